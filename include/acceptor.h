@@ -6,10 +6,14 @@
 #include <thread>
 #include <functional>
 #include "connection_pool.h"
+#include "event_loop.h"
+#include <chrono>
 #include "interfaces/IConnection.h"
+#include "connection.h"
+#include <netinet/in.h>
 class Acceptor {
 public:
-    using AcceptCallback = std::function<void(std::shared_ptr<IConnection> conn, int clientFd, const BackendConfig& backend)>;
+    using AcceptCallback = std::function<void(std::shared_ptr<IConnection> conn, int clientFd, const Backend& backend)>;
 
     Acceptor(const ListenConfig& listenConfig,
              Router& router,
@@ -23,9 +27,21 @@ public:
 
     void stop();
     bool isRunning() const noexcept { return m_Running.load(); }
-    void onConnectionClosed(std::shared_ptr<IConnection> conn);
+    // Accepts until EAGAIN; used directly by reactors that own a SO_REUSEPORT listener.
+    int acceptPending();
+    int getListenFd() const noexcept { return m_ServerFd; }
+    void setConnectionOptions(const ConnectionOptions& options) { m_ConnectionOptions = options; }
+    // The loop that owns the listener; acceptPending() then retries on its timer after
+    // accept() fails for lack of resources (EMFILE, ENOBUFS, ...).
+    void attachEventLoop(IEventLoop* loop) { m_Loop = loop; }
 private:
+    static constexpr std::chrono::milliseconds ACCEPT_RETRY_DELAY{50};
+    static constexpr std::chrono::seconds ACCEPT_ERROR_LOG_INTERVAL{1};
+
+    void scheduleRetry();
+    void logAcceptError(int err);
     void acceptLoop();
+    void handleAccepted(int clientFd, const sockaddr_in& clientAddr);
     void setupListeningSocket();
     void closeListeningSocket();
     ConnectionPool& m_ConnectionPool;
@@ -33,6 +49,7 @@ private:
     std::string m_Host;
     uint16_t m_Port;
     int m_Backlog;
+    bool m_ReusePort;
 
     std::atomic<bool> m_Running{false};
     std::thread m_Thread;
@@ -40,6 +57,11 @@ private:
     Router& m_Router;
     ILogger& m_Logger;
     AcceptCallback m_OnAcceptCallback;
+    ConnectionOptions m_ConnectionOptions;
 
+    IEventLoop* m_Loop{nullptr};
+    TimerId m_RetryTimer{INVALID_TIMER_ID};
+    bool m_AcceptStalled{false};
     int m_AcceptErrorCount{0};
+    std::chrono::steady_clock::time_point m_LastAcceptErrorLog{};
 };
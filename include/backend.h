@@ -0,0 +1,96 @@
+#pragma once
+#include "config_types.h"
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+using BackendId = uint32_t;
+
+// Pool-wide cap on backends out of rotation for outlier detection at once (open or
+// half-open), so a fleet-wide blip cannot eject every backend.
+struct EjectionBudget {
+    std::atomic<uint32_t> ejected{0};
+    uint32_t limit = UINT32_MAX;
+
+    bool tryTake() noexcept {
+        uint32_t current = ejected.load(std::memory_order_relaxed);
+        do {
+            if (current >= limit)
+                return false;
+        } while (!ejected.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+        return true;
+    }
+    void release() noexcept { ejected.fetch_sub(1, std::memory_order_relaxed); }
+};
+
+// Live per-backend load, written from every reactor: one cache line per backend so
+// neighbours' updates do not false-share.
+struct alignas(64) BackendStats {
+    using Clock = std::chrono::steady_clock;
+    // Half-life-ish horizon of the latency estimate (Finagle's peak EWMA default).
+    static constexpr std::chrono::seconds LATENCY_DECAY{10};
+
+    std::atomic<uint32_t> active{0};   // client connections currently routed here
+    // Peak EWMA of connect and first-byte latency: a slower sample replaces the
+    // estimate outright, faster ones pull it down gradually.
+    std::atomic<uint64_t> latencyNanos{0};
+    std::atomic<int64_t> latencyStamp{0};   // Clock ticks of the last sample
+
+    void observeLatency(std::chrono::nanoseconds sample, Clock::time_point now = Clock::now()) noexcept;
+    // Expected cost of one more client: the latency estimate (decayed toward zero since
+    // its last sample, so a backend that went quiet gets probed again) times the
+    // clients it already has plus this one.
+    double cost(Clock::time_point now = Clock::now()) const noexcept;
+
+    // Passive outlier detection, armed when `outlierPolicy` is set (see BackendPool::
+    // enableOutlierDetection). The data path reports connect failures, timeouts and
+    // resets; enough in a row eject the backend (circuit open), and once the ejection
+    // runs out one half-open trial client decides whether it closes again or re-opens
+    // for twice as long.
+    enum class Circuit : uint64_t { Closed = 0, Open = 1, HalfOpen = 2 };
+    // How long a half-open trial may stay unresolved before another client is let through.
+    static constexpr std::chrono::seconds TRIAL_TIMEOUT{10};
+
+    const OutlierDetectionConfig* outlierPolicy = nullptr;
+    EjectionBudget* ejectionBudget = nullptr;   // shared by the pool; null means uncapped
+    // State in the low two bits, above them the Clock ticks it lasts until (open: the
+    // end of the ejection, half-open: the trial's timeout), so both change in one CAS.
+    std::atomic<uint64_t> circuit{0};
+    std::atomic<uint32_t> consecutiveFailures{0};
+    std::atomic<uint32_t> ejections{0};      // back-to-back ejections, sets the next one's length
+    std::atomic<int64_t> closedSince{0};     // Clock ticks of the last reinstatement
+
+    Circuit circuitState() const noexcept {
+        return static_cast<Circuit>(circuit.load(std::memory_order_acquire) & 3);
+    }
+    // False while ejected or while another client holds the half-open trial. Otherwise
+    // true, and if the circuit was open the caller now holds the trial and must route
+    // its client here. Closed costs one load, no clock read.
+    bool admits() noexcept {
+        uint64_t word = circuit.load(std::memory_order_acquire);
+        return (word & 3) == 0 || claimTrial(word, Clock::now());
+    }
+    // Closes a half-open circuit and clears the failure streak; only loads when neither is set.
+    void recordSuccess() noexcept;
+    // Returns the length of the ejection this failure started, or zero.
+    Clock::duration recordFailure(Clock::time_point now = Clock::now()) noexcept;
+
+private:
+    bool claimTrial(uint64_t word, Clock::time_point now) noexcept;
+    Clock::duration eject(uint64_t expected, Clock::time_point now) noexcept;
+};
+
+// A configured backend, interned once at load: router, pool and connections key
+// everything by the dense `id`, and connect straight to the pre-resolved address.
+struct Backend : BackendConfig {
+    BackendId id = 0;
+    std::string name;            // "host:port", for logs
+    sockaddr_storage addr{};
+    socklen_t addrLen = 0;       // 0 if the host did not resolve
+    BackendStats* stats = nullptr;   // owned by BackendPool; null for a standalone Backend
+
+    bool isResolved() const noexcept { return addrLen != 0; }
+
+    static Backend resolve(const BackendConfig& config, BackendId id);
+};
@@ -1,18 +1,60 @@
 #pragma once
 #include "config_types.h"
+#include "backend.h"
 #include <vector>
 #include <atomic>
+#include <memory>
 #include <mutex>
 
 class BackendPool {
 public:
+    // Interns the configured backends: IDs are their indices in `backends`.
     explicit BackendPool(const std::vector<BackendConfig>& backends);
 
-    BackendConfig getNextBackend();
+    // Smooth weighted round robin: picks are spread in proportion to the backends'
+    // weights and interleaved (5:1:1 gives a a b a c a a, not a a a a a b c).
+    const Backend& getNextBackend();
+    const Backend& at(BackendId id) const { return m_Interned[id]; }
+    size_t size() const noexcept { return m_Interned.size(); }
+    uint32_t activeConnections(BackendId id) const {
+        return m_Stats[id].active.load(std::memory_order_relaxed);
+    }
+
+    // One bit per backend ID, cleared by HealthMonitor while a backend is down; every
+    // backend starts healthy. Selection skips down backends, but with none healthy it
+    // fails open rather than refuse every client.
+    bool isHealthy(BackendId id) const noexcept {
+        return (m_Healthy[id / 64].load(std::memory_order_relaxed) >> (id % 64)) & 1;
+    }
+    void setHealthy(BackendId id, bool healthy) noexcept;
+    size_t healthyCount() const noexcept { return m_HealthyCount.load(std::memory_order_relaxed); }
+    // Arms passive outlier detection on every backend's stats (see BackendStats::Circuit),
+    // with at most maxEjectionPercent of the backends (but always one) ejected at once.
+    void enableOutlierDetection(const OutlierDetectionConfig& config);
+    bool isEjected(BackendId id) const noexcept {
+        return m_Stats[id].circuitState() != BackendStats::Circuit::Closed;
+    }
+    // In rotation: healthy and not ejected. May hand the caller a half-open trial (see
+    // BackendStats::admits), so only ask about a backend you will route to if true.
+    bool admits(BackendId id) noexcept { return isHealthy(id) && m_Stats[id].admits(); }
 
     const std::vector<BackendConfig>& getAllBackends() const;
 
 private:
+    // Cap on one schedule period; larger weight sums are scaled down to fit.
+    static constexpr uint64_t MAX_SCHEDULE = 1 << 16;
+
+    void buildSchedule();
+
     std::vector<BackendConfig> m_Backends;
+    std::vector<Backend> m_Interned;
+    std::unique_ptr<BackendStats[]> m_Stats;
+    // One period of the weighted sequence, precomputed so that selection is a single
+    // fetch_add shared by every reactor rather than a lock around mutable weights.
+    std::vector<BackendId> m_Schedule;
     std::atomic<size_t> m_CurrentIndex{0};
+    std::unique_ptr<std::atomic<uint64_t>[]> m_Healthy;
+    std::atomic<size_t> m_HealthyCount{0};
+    OutlierDetectionConfig m_OutlierPolicy;
+    EjectionBudget m_EjectionBudget;
 };
@@ -0,0 +1,45 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Process-wide pool of fixed-size I/O chunks carved from one mmap'd arena whose size
+// is the memory budget. Chunks are handed out lazily (RSS grows only as they are
+// first touched) and recycled through a lock-free free list; once the budget is
+// spent acquire() returns nullptr and callers are expected to back off.
+class BufferPool {
+public:
+    BufferPool(size_t chunkSize, size_t memoryBudget, bool hugePages = false);
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Thread-safe.
+    char* acquire() noexcept;
+    void release(char* chunk) noexcept;
+
+    size_t chunkSize() const noexcept { return m_ChunkSize; }
+    size_t capacity() const noexcept { return m_ChunkCount; }
+    size_t inUse() const noexcept { return m_InUse.load(std::memory_order_relaxed); }
+    size_t available() const noexcept { return m_ChunkCount - std::min(inUse(), m_ChunkCount); }
+    bool owns(const char* chunk) const noexcept { return chunk >= m_Arena && chunk < m_Arena + m_ArenaSize; }
+    size_t bytesInUse() const noexcept { return inUse() * m_ChunkSize; }
+    bool usesHugePages() const noexcept { return m_HugeTlb; }
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    char* m_Arena{nullptr};
+    size_t m_ArenaSize{0};
+    size_t m_ChunkSize;
+    size_t m_ChunkCount{0};
+    bool m_HugeTlb{false};
+    std::unique_ptr<std::atomic<uint32_t>[]> m_Next;
+    // Treiber stack head: (ABA tag << 32) | chunk index.
+    alignas(64) std::atomic<uint64_t> m_FreeHead{NIL};
+    alignas(64) std::atomic<size_t> m_Carved{0};
+    std::atomic<size_t> m_InUse{0};
+};
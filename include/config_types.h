@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <cstdint>
@@ -10,11 +11,13 @@ struct ListenConfig {
     std::string host;
     uint16_t port;
     int backlog = 128;
+    bool reusePort = false;
 };
 
 struct BackendConfig {
     std::string host;
     uint16_t port;
+    uint32_t weight = 1;   // relative share of round-robin picks
 };
 
 struct LoggingConfig {
@@ -25,16 +28,75 @@ struct LoggingConfig {
 
 struct ReactorConfig {
     int threads = 0;               
+    std::string eventLoop = "default";
+    std::string forwarding = "copy";
     size_t connectionReadBuffer = 65536;
     size_t connectionWriteBuffer = 65536;
+    int idleTimeoutSeconds = 30;
+    int connectTimeoutMs = 3000;
+    // Each reactor logs its open connections and their state bytes this often (0 = never).
+    int statsIntervalMs = 60000;
+};
+
+struct BufferPoolConfig {
+    size_t memoryBudgetBytes = 268435456;   // 0 disables the shared pool
+    bool hugePages = false;
 };
 
 struct ShutdownConfig {
     int drainSeconds = 10;
 };
 
+struct RoutingConfig {
+    std::string algorithm = "roundRobin";   // "roundRobin" | "leastConnections" | "powerOfTwoChoices" | "consistentHash"
+};
+
+struct HealthCheckConfig {
+    bool enabled = false;
+    int intervalMs = 5000;
+    int timeoutMs = 1000;
+    // Consecutive probe results it takes to mark a backend up again, or down.
+    int healthyThreshold = 2;
+    int unhealthyThreshold = 3;
+    // Optional payload probe: `send` is written once connected, and the reply must
+    // start with `expect` (either may be empty, e.g. expect alone checks a banner).
+    std::string send;
+    std::string expect;
+};
+
+struct OutlierDetectionConfig {
+    bool enabled = false;
+    // Consecutive connect failures, timeouts or resets that eject a backend. Each repeat
+    // ejection doubles, from baseEjectionMs up to maxEjectionMs; a backend that stays in
+    // rotation for maxEjectionMs starts again from the base.
+    int consecutiveFailures = 5;
+    int baseEjectionMs = 30000;
+    int maxEjectionMs = 300000;
+    // Most backends ejected at once, as a percentage of the pool (at least one).
+    int maxEjectionPercent = 50;
+};
+
 struct ConnectionPoolConfig {
     size_t maxConnectionsPerBackend = 10;
+    // Warm (idle) connections kept per backend: at least minIdle, scaled up with the
+    // recent acquire rate, never more than maxIdle. Unless set, maxIdle defaults to 4
+    // (or minIdle if larger), clamped to maxConnectionsPerBackend.
+    size_t minIdle = 0;
+    size_t maxIdle = 4;
+    int maintenanceIntervalMs = 1000;
+    // Idle connections unused for idleTtlMs are closed; the sweep runs every
+    // reapIntervalMs on a reactor timer.
+    int idleTtlMs = 300000;
+    int reapIntervalMs = 1000;
+    // Concurrent clients per backend (0 = unlimited). Clients over the cap wait up to
+    // waitTimeoutMs in a FIFO of waitQueueDepth (0 = refuse them at once).
+    size_t maxActivePerBackend = 0;
+    size_t waitQueueDepth = 0;
+    int waitTimeoutMs = 1000;
+    // Return a backend connection to the pool when its client closes at a clean
+    // request/response boundary. Opt-in: only safe for keep-alive request/response
+    // protocols such as HTTP/1.1, not TLS passthrough or server-first protocols.
+    bool reuseBackendConnections = false;
 };
 
 struct LoadBalancerConfig {
@@ -43,7 +105,11 @@ struct LoadBalancerConfig {
     LoggingConfig logging;
     ReactorConfig reactor;
     ShutdownConfig shutdown;
+    RoutingConfig routing;
+    HealthCheckConfig healthCheck;
+    OutlierDetectionConfig outlierDetection;
     ConnectionPoolConfig connectionPool;
+    BufferPoolConfig bufferPool;
 };
 
 inline void from_json(const json& j, ListenConfig& c) {
@@ -57,6 +123,7 @@ inline void from_json(const json& j, ListenConfig& c) {
     c.port = static_cast<uint16_t>(port);
 
     if (j.contains("backlog")) j.at("backlog").get_to(c.backlog);
+    if (j.contains("reusePort")) j.at("reusePort").get_to(c.reusePort);
 }
 
 inline void from_json(const json& j, BackendConfig& c) {
@@ -68,6 +135,13 @@ inline void from_json(const json& j, BackendConfig& c) {
         throw runtime_error("Configuration error: Backend port must be between 1 and 65535.");
 
     c.port = static_cast<uint16_t>(port);
+    if (j.contains("weight")) {
+        int64_t weight;
+        j.at("weight").get_to(weight);
+        if (weight < 1 || weight > UINT32_MAX)
+            throw runtime_error("Configuration error: Backend weight must be positive.");
+        c.weight = static_cast<uint32_t>(weight);
+    }
 }
 
 inline void from_json(const json& j, LoggingConfig& c) {
@@ -81,17 +155,62 @@ inline void from_json(const json& j, LoggingConfig& c) {
 
 inline void from_json(const json& j, ReactorConfig& c) {
     if (j.contains("threads")) j.at("threads").get_to(c.threads);
+    if (j.contains("eventLoop")) j.at("eventLoop").get_to(c.eventLoop);
+    if (j.contains("forwarding")) j.at("forwarding").get_to(c.forwarding);
     if (j.contains("connectionReadBuffer")) j.at("connectionReadBuffer").get_to(c.connectionReadBuffer);
     if (j.contains("connectionWriteBuffer")) j.at("connectionWriteBuffer").get_to(c.connectionWriteBuffer);
+    if (j.contains("idleTimeoutSeconds")) j.at("idleTimeoutSeconds").get_to(c.idleTimeoutSeconds);
+    if (j.contains("connectTimeoutMs")) j.at("connectTimeoutMs").get_to(c.connectTimeoutMs);
+    if (j.contains("statsIntervalMs")) j.at("statsIntervalMs").get_to(c.statsIntervalMs);
+}
+
+inline void from_json(const json& j, BufferPoolConfig& c) {
+    if (j.contains("memoryBudgetBytes")) j.at("memoryBudgetBytes").get_to(c.memoryBudgetBytes);
+    if (j.contains("hugePages")) j.at("hugePages").get_to(c.hugePages);
 }
 
 inline void from_json(const json& j, ShutdownConfig& c) {
     if (j.contains("drainSeconds")) j.at("drainSeconds").get_to(c.drainSeconds);
 }
 
+inline void from_json(const json& j, RoutingConfig& c) {
+    if (j.contains("algorithm")) j.at("algorithm").get_to(c.algorithm);
+}
+
 inline void from_json(const json& j, ConnectionPoolConfig& c) {
     if (j.contains("maxConnectionsPerBackend"))
         j.at("maxConnectionsPerBackend").get_to(c.maxConnectionsPerBackend);
+    if (j.contains("minIdle")) j.at("minIdle").get_to(c.minIdle);
+    if (j.contains("maxIdle"))
+        j.at("maxIdle").get_to(c.maxIdle);
+    else   // the default never exceeds the per-backend cap; only an explicit maxIdle is validated
+        c.maxIdle = std::min(std::max(c.maxIdle, c.minIdle), c.maxConnectionsPerBackend);
+    if (j.contains("maintenanceIntervalMs")) j.at("maintenanceIntervalMs").get_to(c.maintenanceIntervalMs);
+    if (j.contains("idleTtlMs")) j.at("idleTtlMs").get_to(c.idleTtlMs);
+    if (j.contains("reapIntervalMs")) j.at("reapIntervalMs").get_to(c.reapIntervalMs);
+    if (j.contains("maxActivePerBackend")) j.at("maxActivePerBackend").get_to(c.maxActivePerBackend);
+    if (j.contains("waitQueueDepth")) j.at("waitQueueDepth").get_to(c.waitQueueDepth);
+    if (j.contains("waitTimeoutMs")) j.at("waitTimeoutMs").get_to(c.waitTimeoutMs);
+    if (j.contains("reuseBackendConnections"))
+        j.at("reuseBackendConnections").get_to(c.reuseBackendConnections);
+}
+
+inline void from_json(const json& j, HealthCheckConfig& c) {
+    if (j.contains("enabled")) j.at("enabled").get_to(c.enabled);
+    if (j.contains("intervalMs")) j.at("intervalMs").get_to(c.intervalMs);
+    if (j.contains("timeoutMs")) j.at("timeoutMs").get_to(c.timeoutMs);
+    if (j.contains("healthyThreshold")) j.at("healthyThreshold").get_to(c.healthyThreshold);
+    if (j.contains("unhealthyThreshold")) j.at("unhealthyThreshold").get_to(c.unhealthyThreshold);
+    if (j.contains("send")) j.at("send").get_to(c.send);
+    if (j.contains("expect")) j.at("expect").get_to(c.expect);
+}
+
+inline void from_json(const json& j, OutlierDetectionConfig& c) {
+    if (j.contains("enabled")) j.at("enabled").get_to(c.enabled);
+    if (j.contains("consecutiveFailures")) j.at("consecutiveFailures").get_to(c.consecutiveFailures);
+    if (j.contains("baseEjectionMs")) j.at("baseEjectionMs").get_to(c.baseEjectionMs);
+    if (j.contains("maxEjectionMs")) j.at("maxEjectionMs").get_to(c.maxEjectionMs);
+    if (j.contains("maxEjectionPercent")) j.at("maxEjectionPercent").get_to(c.maxEjectionPercent);
 }
 
 inline void from_json(const json& j, LoadBalancerConfig& c) {
@@ -100,5 +219,9 @@ inline void from_json(const json& j, LoadBalancerConfig& c) {
     if (j.contains("logging"))  j.at("logging").get_to(c.logging);
     if (j.contains("reactor"))  j.at("reactor").get_to(c.reactor);
     if (j.contains("shutdown")) j.at("shutdown").get_to(c.shutdown);
+    if (j.contains("routing")) j.at("routing").get_to(c.routing);
+    if (j.contains("healthCheck")) j.at("healthCheck").get_to(c.healthCheck);
+    if (j.contains("outlierDetection")) j.at("outlierDetection").get_to(c.outlierDetection);
     if (j.contains("connectionPool")) j.at("connectionPool").get_to(c.connectionPool);
+    if (j.contains("bufferPool")) j.at("bufferPool").get_to(c.bufferPool);
 }
@@ -3,12 +3,38 @@
 #include "logger.h"
 #include <string>
 #include "interfaces/IConnection.h"
+#include "ring_buffer.h"
+#include "buffer_pool.h"
+#include "timer_wheel.h"
+
+class ConnectionPool;
+
+struct ConnectionOptions {
+    // Forward with splice(2) through a pipe per direction instead of recv/send (Linux only).
+    bool useSplice = false;
+    size_t readBufferSize = 65536;    // client -> backend
+    size_t writeBufferSize = 65536;   // backend -> client
+    // Bytes moved per direction per readiness event before yielding to other fds.
+    size_t wakeupBudget = 1048576;
+    // Shared chunk pool for ring storage (sizes are capped at its chunk size). When null
+    // rings come from the heap. Either way a ring is only held while bytes are queued.
+    BufferPool* bufferPool = nullptr;
+    // Told when a backend fd lent by the pool is closed, so it stops counting it.
+    ConnectionPool* connectionPool = nullptr;
+    // Return the backend socket to connectionPool when the client closes at a clean
+    // request/response boundary, instead of closing it.
+    bool reuseBackend = false;
+};
+
 class Connection : public IConnection {
 public:
-    Connection(int clientFd, int backendFd, const BackendConfig& backend, ILogger& logger);
+    // `backend` is interned by BackendPool and must outlive the connection.
+    Connection(int clientFd, int backendFd, const Backend& backend, ILogger& logger,
+               const ConnectionOptions& options = {});
     virtual ~Connection();
 
     virtual bool connectToBackend() override;
+    void adoptBackendFd(int fd) override;
     virtual void closeAll() override;
     virtual void onReadable(int fd) override;
     virtual void onWritable(int fd) override;
@@ -17,20 +43,86 @@ public:
     int getBackendFd() const override { return m_BackendFd; }
     bool isActive() const noexcept { return m_Connected; }
     bool isConnected() const override { return m_Connected; }
-    void setConnected(bool connected) override { m_Connected = connected; }
-    const BackendConfig& getBackendConfig() const override { return m_Backend; }
+    void setConnected(bool connected) override;
+    void noteBackendFailure() override;
+    const Backend& getBackend() const override { return m_Backend; }
     bool hasBackendOpen() const override { return m_BackendFd >= 0; }
     bool isClientFd(int fd) const override { return fd == m_ClientFd; }
     void refreshActivity();
     virtual bool isIdleFor(std::chrono::seconds duration) const override;
-    
+    std::chrono::steady_clock::time_point getLastActivity() const override { return m_LastActivity; }
+    bool isSpliceEnabled() const noexcept { return m_Options.useSplice; }
+    void attachEventLoop(IEventLoop* loop) override;
+    size_t bufferedToBackend() const noexcept { return m_Upstream.buffer.size() + m_Upstream.pipe.pending; }
+    size_t bufferedToClient() const noexcept { return m_Downstream.buffer.size() + m_Downstream.pipe.pending; }
+    bool isReadPaused(int fd) const noexcept;
+    size_t stateBytes() const noexcept override;
+
 private:
+    struct SplicePipe {
+        int readFd = -1;
+        int writeFd = -1;
+        size_t pending = 0;
+    };
+
+    // One forwarding direction. Reading the source pauses once `buffer` reaches the high
+    // watermark (or a spliced pipe cannot be emptied) and resumes at the low watermark.
+    struct Direction {
+        explicit Direction(size_t capacity)
+            : buffer(capacity, false), highWatermark(capacity), lowWatermark(capacity / 2) {}
+        RingBuffer buffer;
+        SplicePipe pipe;
+        size_t highWatermark;
+        size_t lowWatermark;
+        bool sourcePaused = false;
+        bool waitingForMemory = false;   // paused because the buffer pool is exhausted
+        bool blockedOnTarget = false;    // unbuffered forwarding waits for the target to drain
+    };
+
+    struct Interest {
+        bool read;
+        bool write;
+    };
+
+    void copyForward(int fd, int targetFd, Direction& dir);
+    bool sendDirect(int targetFd, Direction& dir, const char* data, size_t len);
+    bool spliceForward(int fd, int targetFd, Direction& dir);
+    bool flush(int targetFd, Direction& dir);
+    bool flushPipe(SplicePipe& pipe, int targetFd);
+    void applyBackpressure(int sourceFd, Direction& dir);
+    void updateInterest(int fd);
+    void rearm(int fd);
+    bool ensureStorage(Direction& dir);
+    void releaseStorage(Direction& dir);
+    bool memoryExhausted() const noexcept;
+    bool forwardUnbuffered(int fd, int targetFd, Direction& dir);
+    void waitForMemory(int fd, Direction& dir);
+    void scheduleMemoryRetry();
+    void retryMemory();
+    void closeFd(int& fd);
+    void onIoError(int fd);
+    void closePipes();
+    void noteReceived(const Direction& dir) noexcept;
+    bool backendReusable() const;
+    void releaseBackend();
+
     int m_ClientFd;
     int m_BackendFd;
-    BackendConfig m_Backend;
+    const Backend& m_Backend;
     ILogger& m_Logger;
     bool m_Connected;
-    std::unordered_map<int, std::string> m_PendingWrites;
     std::chrono::steady_clock::time_point m_LastActivity;
-    
+    ConnectionOptions m_Options;
+    Direction m_Upstream;     // client -> backend
+    Direction m_Downstream;   // backend -> client
+    IEventLoop* m_Loop = nullptr;
+    Interest m_ClientInterest{true, false};
+    Interest m_BackendInterest{true, true};
+    TimerId m_MemoryRetryTimer{INVALID_TIMER_ID};
+    bool m_ClientSpoke = false;
+    bool m_BackendSpokeLast = false;
+    // Latency samples for the backend's stats: a pending connect, and the client bytes
+    // still waiting for the backend's first reply.
+    std::chrono::steady_clock::time_point m_ConnectStart{};
+    std::chrono::steady_clock::time_point m_TurnStart{};
 };
@@ -1,30 +1,167 @@
 #pragma once
 #include "config_types.h"
-#include <unordered_map>
+#include "backend.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <vector>
 #include <mutex>
 
 struct PooledBackendConn {
     int fd;
-    bool inUse;
     std::chrono::steady_clock::time_point lastUsed;
 };
 
+// Idle backend connections, sharded per thread. Each thread pushes and pops on its
+// own shard's per-backend LIFO stack, so acquire/release stay core-local; a thread
+// whose shard is dry steals from the others (try_lock, never waits). Which fds the
+// pool owns, and whether they are lent out, lives in an fd-indexed atomic table.
+// Backends are addressed by their interned ID, which must be below maxBackends.
+// With maxActivePerBackend set, admit() also caps how many clients use a backend at
+// once; clients over the cap wait in a bounded per-backend FIFO and are handed the
+// next connection or slot that frees up.
+// Idle fds are also armed (one-shot) in a private epoll set for EPOLLRDHUP/EPOLLIN:
+// an idle backend socket should never become readable, so any event means the backend
+// closed it or broke protocol. The set's fd is watched by a reactor, which calls
+// reapClosed() when it fires and cleanupIdleConnections() on a timer.
 class ConnectionPool {
 public:
-    ConnectionPool(const ConnectionPoolConfig& config)
-        : m_MaxConnectionsPerBackend(config.maxConnectionsPerBackend) {}
-    ConnectionPool() : m_MaxConnectionsPerBackend(10) {}
-    int acquire(const BackendConfig& backend);
-    void release(const BackendConfig& backend, int fd);
-    int addNewConnection(const BackendConfig& backend); 
-    void cleanupIdleConnections();
-    bool isConnectionInPool(const BackendConfig& backend, int fd);
+    static constexpr size_t DEFAULT_MAX_BACKENDS = 1024;
+
+    enum class Admission { Granted, Full, Queued, Rejected };
+    using WaitTicket = uint64_t;
+    // Runs on whichever thread frees the slot: a lent pooled fd, or -1 to dial.
+    using GrantCallback = std::function<void(int fd)>;
+
+    // shardCount 0 means one shard per hardware thread.
+    explicit ConnectionPool(const ConnectionPoolConfig& config, size_t maxBackends = DEFAULT_MAX_BACKENDS,
+                            size_t shardCount = 0);
+    ConnectionPool() : ConnectionPool(ConnectionPoolConfig{}) {}
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Lends an idle connection; -1 if there is none. Never dials, so it never blocks:
+    // callers connect on their own (non-blocking, from the reactor) instead.
+    int acquire(const Backend& backend);
+    // A client's claim on a backend slot. Granted: `fd` is a lent idle connection, or -1
+    // to dial one and adopt() it. Full: the backend is at maxActivePerBackend (or has
+    // clients waiting); call wait() to queue.
+    Admission admit(const Backend& backend, int& fd);
+    // Queues behind the backend's current users: Queued (onGrant runs later), Granted
+    // if a slot freed meanwhile, or Rejected when the queue is full or disabled.
+    Admission wait(const Backend& backend, GrantCallback onGrant, int& fd, WaitTicket& ticket);
+    // Withdraws a queued client; false if it was already granted.
+    bool cancelWait(const Backend& backend, WaitTicket ticket);
+    // Gives up an admitted slot that never got a backend fd (e.g. the dial failed).
+    void releaseSlot(const Backend& backend);
+    // Tracks an fd an admitted client dialed itself, so discard() frees its slot.
+    void adopt(const Backend& backend, int fd);
+    std::chrono::milliseconds waitTimeout() const noexcept { return m_WaitTimeout; }
+    // Takes back a lent or adopted fd, which goes straight to the first waiting client
+    // if there is one; false (fd untouched) for anything else.
+    bool release(const Backend& backend, int fd);
+    // One backend's share of a batched dial: `dialed` is filled in with how many of
+    // the `wanted` connections made it into the pool.
+    struct DialRequest {
+        const Backend* backend;
+        size_t wanted;
+        size_t dialed = 0;
+    };
+    // Dials one more idle connection into the pool. Blocks for up to the connect
+    // timeout; not for the accept path.
+    int addNewConnection(const Backend& backend);
+    // Dials all the requested connections at once: the connects run non-blocking and
+    // are polled together, so the whole batch takes at most one connect timeout and an
+    // unreachable backend does not hold up the others.
+    void addNewConnections(std::vector<DialRequest>& requests);
+    // A lent fd that its borrower closed instead of releasing; it no longer counts
+    // against the backend's cap.
+    void discard(const Backend& backend, int fd);
+    // Closes idle connections unused for longer than the configured TTL; returns how many.
+    size_t cleanupIdleConnections();
+    // Drains the liveness set and closes the idle connections it reports; lent fds
+    // that fire are ignored. Returns how many were closed.
+    size_t reapClosed();
+    // Readable when reapClosed() has work; -1 where liveness watching is unsupported.
+    int watchFd() const noexcept { return m_WatchFd; }
+    bool isConnectionInPool(const Backend& backend, int fd);
+
+    // For pool maintenance (PoolWarmer); these visit every shard.
+    size_t idleCount(const Backend& backend);
+    // acquire() calls since the previous call, hits and misses alike.
+    size_t takeDemand(const Backend& backend);
+    // Closes the oldest idle connections beyond `keep`.
+    void trimIdle(const Backend& backend, size_t keep);
+    size_t shardCount() const noexcept { return m_Shards.size(); }
+    // Pins the calling thread to shard `index` (modulo shardCount()); each reactor thread
+    // binds its reactor index so it gets a shard of its own. Threads that never bind are
+    // spread over the shards in the order they first touch a pool.
+    static void bindThreadToShard(size_t index) noexcept;
 
 private:
-    void removeOldestIdleConnections();
-    int CONNECT_TIMEOUT_MS = 3000;
-    std::unordered_map<std::string, std::vector<PooledBackendConn>> m_Pool;
-    std::mutex m_Mutex;
+    static constexpr size_t SEGMENT_BITS = 12;
+    using Segment = std::array<std::atomic<uint32_t>, size_t{1} << SEGMENT_BITS>;
+
+    struct BackendState {
+        std::atomic<size_t> open{0};   // dialed by the pool: idle + lent, across all shards
+    };
+
+    struct Waiter {
+        WaitTicket ticket;
+        GrantCallback grant;
+    };
+
+    // Only allocated when maxActivePerBackend is set.
+    struct WaitQueue {
+        std::mutex mutex;
+        size_t active = 0;   // admitted clients holding a slot
+        std::deque<Waiter> waiters;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;   // only contended while another thread steals
+        // Per backend ID; LIFO, so the most recently used connection is the warmest.
+        std::vector<std::vector<PooledBackendConn>> idle;
+        std::vector<size_t> demand;
+    };
+
+    // Owner word: 0 = not pooled, otherwise (backend ID + 1) << 2 | adopted << 1 | lent.
+    static constexpr uint32_t LENT = 1;
+    static constexpr uint32_t ADOPTED = 2;
+    static constexpr std::chrono::milliseconds CONNECT_TIMEOUT{3000};
+    static uint32_t ownerWord(BackendId id, uint32_t flags) { return (id + 1) << 2 | flags; }
+    static BackendId ownerId(uint32_t word) { return (word >> 2) - 1; }
+
+    size_t homeShard() const noexcept;
+    std::atomic<uint32_t>* ownerSlot(int fd, bool create);
+    int dialAll(DialRequest* requests, size_t count);
+    int startDial(const Backend& backend, bool& connected);
+    void abandonDial(BackendId id, int fd);
+    void poolDialed(BackendId id, int fd);
+    void forget(int fd, BackendId id);
+    void watch(int fd);
+    bool evictIdle(int fd, BackendId id);
+    bool handOff(BackendId id, int fd);
+    bool reserveOpen(BackendId id);
+
     const size_t m_MaxConnectionsPerBackend;
+    const std::chrono::milliseconds m_IdleTtl;
+    const size_t m_MaxActive;
+    const size_t m_WaitQueueDepth;
+    const std::chrono::milliseconds m_WaitTimeout;
+    std::unique_ptr<WaitQueue[]> m_Queues;
+    std::atomic<WaitTicket> m_NextTicket{1};
+    int m_WatchFd{-1};
+    std::vector<std::unique_ptr<Shard>> m_Shards;
+    std::unique_ptr<BackendState[]> m_Backends;
+    size_t m_MaxBackends;
+    // Segment directory, sized at construction to cover every fd RLIMIT_NOFILE allows.
+    std::unique_ptr<std::atomic<Segment*>[]> m_Owners;
+    size_t m_SegmentCount{0};
+    std::atomic<size_t> m_NextDialShard{0};
 };
@@ -2,6 +2,8 @@
 #include <vector>
 #include <memory>
 #include <functional>
+#include <chrono>
+#include "timer_wheel.h"
 
 struct Event {
     int fd;
@@ -14,6 +16,7 @@ struct Event {
 class IEventLoop {
 public:
     using EventHandler = std::function<void(const Event&)>;
+    using TimerCallback = std::function<void()>;
 
     virtual ~IEventLoop() = default;
 
@@ -22,4 +25,11 @@ public:
     virtual int wait(std::vector<Event>& events, int timeoutMs) = 0;
     virtual void closeLoop() = 0;
     virtual void updateFd(int fd, bool wantRead, bool wantWrite) = 0;
+    // One-shot timers on the loop thread; wait() shortens its timeout to the next due
+    // timer, and runTimers() fires the due ones. Callers run timers only after the
+    // batch from wait() is dispatched, so a timer never closes (or reuses) an fd whose
+    // event is still pending in it.
+    virtual TimerId addTimer(std::chrono::milliseconds delay, TimerCallback callback) = 0;
+    virtual bool cancelTimer(TimerId id) = 0;
+    virtual size_t runTimers() = 0;
 };
@@ -1,5 +1,18 @@
 #pragma once
 #include "event_loop.h"
+#include "interfaces/ILogger.h"
 #include <memory>
+#include <string>
 
-std::unique_ptr<IEventLoop> createEventLoop();
+// backend: "default", "epoll", "io_uring" or "kqueue". io_uring falls back to
+// epoll (with a warning on `logger`) when the kernel does not support it.
+std::unique_ptr<IEventLoop> createEventLoop(ILogger& logger, const std::string& backend = "default");
+
+// The platform's concrete loops, one translation unit each (picked per platform in CMake).
+#ifdef __linux__
+std::unique_ptr<IEventLoop> createEpollEventLoop();
+// Throws std::runtime_error when the kernel lacks the io_uring features it needs.
+std::unique_ptr<IEventLoop> createIoUringEventLoop();
+#elif defined(__APPLE__)
+std::unique_ptr<IEventLoop> createKqueueEventLoop();
+#endif
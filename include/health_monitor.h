@@ -0,0 +1,63 @@
+#pragma once
+#include "backend_pool.h"
+#include "config_types.h"
+#include "interfaces/ILogger.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Active health checks, driven by one reactor's timer and event loop: no thread, and
+// no blocking call, per backend. Every backend is probed once per interval with a
+// non-blocking connect and, if configured, a request whose reply must start with
+// `expect`. Start times are staggered across the interval, so a large fleet costs a
+// steady trickle of probes rather than a burst. After unhealthyThreshold consecutive
+// failures a backend's bit in BackendPool's healthy bitmap is cleared, after
+// healthyThreshold consecutive successes it is set again.
+// Probe sockets sit in a private epoll set whose fd the reactor watches (Linux only;
+// elsewhere eventFd() is -1 and every backend stays healthy).
+class HealthMonitor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    HealthMonitor(BackendPool& backends, const HealthCheckConfig& config, ILogger& logger);
+    ~HealthMonitor();
+
+    HealthMonitor(const HealthMonitor&) = delete;
+    HealthMonitor& operator=(const HealthMonitor&) = delete;
+
+    // Starts the probes that are due and fails those past their timeout.
+    void tick(Clock::time_point now = Clock::now());
+    // Advances probes whose sockets are ready; call when eventFd() is readable.
+    void processEvents(Clock::time_point now = Clock::now());
+    int eventFd() const noexcept { return m_EventFd; }
+    // How often tick() must run to honour the probe timeout.
+    std::chrono::milliseconds tickInterval() const noexcept;
+
+private:
+    enum class Phase : uint8_t { Idle, Connecting, Awaiting };
+
+    struct Probe {
+        int fd = -1;
+        Phase phase = Phase::Idle;
+        Clock::time_point due;   // next start while idle, the deadline while in flight
+        int successes = 0;
+        int failures = 0;
+        std::string reply;
+    };
+
+    void start(BackendId id, Clock::time_point now);
+    void onReady(BackendId id, uint32_t events, Clock::time_point now);
+    bool sendRequest(Probe& probe);
+    // Reads what has arrived; true once the reply is settled, with `ok` its verdict.
+    bool readReply(Probe& probe, bool& ok);
+    void arm(BackendId id, uint32_t events);
+    void finish(BackendId id, bool ok, Clock::time_point now, const char* reason);
+
+    BackendPool& m_Backends;
+    const HealthCheckConfig m_Config;
+    const std::chrono::milliseconds m_Interval;
+    const std::chrono::milliseconds m_Timeout;
+    ILogger& m_Logger;
+    std::vector<Probe> m_Probes;   // per backend ID
+    int m_EventFd{-1};
+};
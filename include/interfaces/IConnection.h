@@ -1,5 +1,8 @@
 #pragma once
-#include "config_types.h"
+#include "backend.h"
+#include <chrono>
+#include <cstddef>
+class IEventLoop;
 class IConnection {
 public:
     virtual ~IConnection() = default;
@@ -8,12 +11,23 @@ public:
     virtual void onClose(int fd) = 0;
     virtual bool isConnected() const = 0;
     virtual void setConnected(bool connected) = 0;
+    // A connect failure, connect timeout or reset, counted against the backend by
+    // outlier detection.
+    virtual void noteBackendFailure() = 0;
     virtual int getBackendFd() const = 0;
     virtual int getClientFd() const = 0;
     virtual bool hasBackendOpen() const = 0;
     virtual bool isClientFd(int fd) const = 0;
     virtual bool connectToBackend() = 0;
+    // Hands over an already-connected backend fd (from the pool) before connectToBackend().
+    virtual void adoptBackendFd(int fd) = 0;
     virtual void closeAll() = 0;
     virtual bool isIdleFor(std::chrono::seconds duration) const = 0;
-    virtual const BackendConfig& getBackendConfig() const = 0;
+    virtual std::chrono::steady_clock::time_point getLastActivity() const = 0;
+    virtual const Backend& getBackend() const = 0;
+    // Called by the owning reactor once the client fd is registered for read and the
+    // backend fd for read+write; the connection then toggles interest for backpressure.
+    virtual void attachEventLoop(IEventLoop* loop) = 0;
+    // User-space bytes the connection currently pins (object plus any borrowed buffers).
+    virtual size_t stateBytes() const = 0;
 };
@@ -6,5 +6,6 @@ public:
     virtual ~ILogger() = default;
     virtual void logInfo(const std::string&) = 0;
     virtual void logDebug(const std::string&) = 0;
+    virtual void logWarn(const std::string&) = 0;
     virtual void logError(const std::string&) = 0;
 };
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Maglev consistent hashing (Eisenbud et al., NSDI '16): a prime-sized table in which
+// every backend claims slots along its own permutation, taking turns, so each owns
+// about size / N of them. Lookup is one index; adding or removing a backend moves only
+// about 1 / N of the keys, since the others' permutations do not depend on it.
+class MaglevTable {
+public:
+    static constexpr size_t DEFAULT_SIZE = 65537;
+
+    // `names` identify the backends (their permutations are seeded by name, not index,
+    // so a backend keeps its slots when its neighbours change). `size` must be prime
+    // and larger than names.size().
+    explicit MaglevTable(const std::vector<std::string>& names, size_t size = DEFAULT_SIZE);
+
+    // Index into `names` of the backend owning `key`.
+    uint32_t lookup(uint64_t key) const noexcept { return m_Entries[key % m_Entries.size()]; }
+    size_t size() const noexcept { return m_Entries.size(); }
+
+private:
+    std::vector<uint32_t> m_Entries;
+};
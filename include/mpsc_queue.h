@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Bounded lock-free multi-producer / single-consumer queue (Vyukov's sequence-per-cell
+// ring). tryPush may be called from any thread; tryPop only from the owning consumer.
+template <typename T>
+class MpscQueue {
+public:
+    explicit MpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        m_Mask = size - 1;
+        m_Cells = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; ++i)
+            m_Cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    bool tryPush(T&& value) {
+        size_t pos = m_Tail.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &m_Cells[pos & m_Mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_Tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;   // full
+            } else {
+                pos = m_Tail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& out) {
+        Cell& cell = m_Cells[m_Head & m_Mask];
+        if (cell.sequence.load(std::memory_order_acquire) != m_Head + 1)
+            return false;
+        out = std::move(cell.value);
+        cell.value = T();
+        cell.sequence.store(m_Head + m_Mask + 1, std::memory_order_release);
+        ++m_Head;
+        return true;
+    }
+
+    size_t capacity() const noexcept { return m_Mask + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    std::unique_ptr<Cell[]> m_Cells;
+    size_t m_Mask{0};
+    alignas(64) std::atomic<size_t> m_Tail{0};
+    alignas(64) size_t m_Head{0};
+};
@@ -1,4 +1,4 @@
 #pragma once
-#include <netinet/in.h>
+#include <sys/socket.h>
 
-int connectWithTimeout(int fd, const sockaddr_in& addr, int timeoutMs);
+int connectWithTimeout(int fd, const sockaddr* addr, socklen_t addrLen, int timeoutMs);
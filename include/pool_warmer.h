@@ -0,0 +1,43 @@
+#pragma once
+#include "backend_pool.h"
+#include "connection_pool.h"
+#include "interfaces/ILogger.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Keeps each backend's idle set warm from a background thread, so clients find a
+// ready connection instead of paying the handshake. The target is the demand expected
+// before the next pass (an EWMA of the acquire rate, with headroom), clamped to
+// [minIdle, maxIdle]. The first pass runs at start(): that is the startup prewarm.
+class PoolWarmer {
+public:
+    PoolWarmer(ConnectionPool& pool, BackendPool& backends, const ConnectionPoolConfig& config, ILogger& logger);
+    ~PoolWarmer();
+
+    PoolWarmer(const PoolWarmer&) = delete;
+    PoolWarmer& operator=(const PoolWarmer&) = delete;
+
+    void start();
+    void stop();
+
+    // One maintenance pass; `elapsed` is the time since the previous pass.
+    void runOnce(std::chrono::duration<double> elapsed);
+    double acquireRate(BackendId id) const { return m_Rate[id]; }
+    size_t targetIdle(BackendId id) const;
+
+private:
+    void run();
+
+    ConnectionPool& m_Pool;
+    BackendPool& m_Backends;
+    const ConnectionPoolConfig m_Config;
+    ILogger& m_Logger;
+    std::vector<double> m_Rate;   // acquires per second, per backend ID
+    std::thread m_Thread;
+    std::mutex m_Mutex;
+    std::condition_variable m_Wake;
+    bool m_Stopping{false};
+};
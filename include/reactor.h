@@ -3,35 +3,112 @@
 #include "interfaces/IConnection.h"
 #include "interfaces/ILogger.h"
 #include "connection_pool.h"
+#include "mpsc_queue.h"
 #include <unordered_map>
+#include <vector>
 #include <memory>
 #include <atomic>
 #include <thread>
+#include <functional>
+
+class HealthMonitor;
+
 class Reactor {
 public:
-    explicit Reactor(std::unique_ptr<IEventLoop> loop, ILogger& logger, ConnectionPool& connectionPool)
-        : m_Loop(std::move(loop)), m_Logger(logger), m_Running(false), m_ConnectionPool(connectionPool) {}
+    using FdHandler = std::function<void(const Event&)>;
+
+    using Task = std::function<void()>;
+    static constexpr size_t DEFAULT_MAILBOX_CAPACITY = 4096;
+
+    explicit Reactor(std::unique_ptr<IEventLoop> loop, ILogger& logger, ConnectionPool& connectionPool,
+                     size_t mailboxCapacity = DEFAULT_MAILBOX_CAPACITY);
     ~Reactor();
     void run();
+    // Thread-safe: queues a task for the reactor thread and wakes it. Returns false if
+    // the mailbox is full.
+    bool post(Task task);
+    // Thread-safe handoff of a newly accepted connection; openConnection then runs on
+    // the reactor thread.
+    bool dispatchConnection(std::shared_ptr<IConnection> conn);
+    // Reactor thread only. Admits the connection to its backend (queueing it if the
+    // backend is at its cap), then starts the non-blocking backend connect and registers
+    // both fds; the connect completes (or fails) on backend writability or its deadline.
+    void openConnection(std::shared_ptr<IConnection> conn);
     void registerConnection(std::shared_ptr<IConnection> conn, int clientFd, int backendFd);
     void unregisterConnection(int fd);
+    // Non-connection fds owned by this reactor (e.g. a SO_REUSEPORT listener).
+    bool registerHandler(int fd, FdHandler handler);
+    void unregisterHandler(int fd);
+    // For handlers that need their own timers (e.g. a listener's accept retry).
+    IEventLoop* eventLoop() noexcept { return m_Loop.get(); }
     void stop();
+    // Once run() has returned: drops every registered connection, closing its fds.
+    void closeConnections();
+    bool isRunning() const noexcept { return m_Running.load(); }
     void handleEvent(Event& e);
     void setIdleTimeout(std::chrono::seconds timeout);
+    void setConnectTimeout(std::chrono::milliseconds timeout);
+    // Makes this reactor the connection pool's janitor: it watches the pool's liveness
+    // fd and sweeps expired idle connections every `interval`. Call before run().
+    void enablePoolMaintenance(std::chrono::milliseconds interval);
+    // Runs `monitor`'s probes on this reactor: its timer ticks here and its probe
+    // sockets' readiness is handled here. Call before run().
+    void enableHealthChecks(HealthMonitor& monitor);
+    struct Stats {
+        size_t connections = 0;
+        size_t stateBytes = 0;   // IConnection::stateBytes summed over them
+    };
+    // Reactor thread only: walks the slot table, so keep it off the per-event path.
+    Stats stats() const;
+    // Logs stats() every `interval` from this reactor's timer. Call before run().
+    void enableStatsReport(std::chrono::milliseconds interval);
+    void closeConnection(IConnection* conn);
     #ifdef UNIT_TEST
         IEventLoop* getEventLoopForTest() { return m_Loop.get(); }
         void injectConnectionForTest(int fd, std::shared_ptr<IConnection> conn) {
-            m_Connections[fd] = std::move(conn);
+            setSlot(fd, std::move(conn));
         }
     #endif
 private:
-    void monitorIdleConnections(); 
+    struct Slot {
+        std::shared_ptr<IConnection> conn;
+        TimerId timer{INVALID_TIMER_ID};   // idle timer on the client fd, connect deadline on the backend fd
+    };
+
+    void setSlot(int fd, std::shared_ptr<IConnection> conn);
+    void clearSlot(int fd);
+    IConnection* connectionAt(int fd) const noexcept {
+        return static_cast<size_t>(fd) < m_Slots.size() ? m_Slots[fd].conn.get() : nullptr;
+    }
+    enum class TimerKind : uint8_t { Idle, Connect };
+    void armTimer(int fd, std::chrono::milliseconds delay, TimerKind kind);
+    void onIdleTimer(int clientFd);
+    void onConnectTimer(int backendFd);
+    void dropClosedFds(IConnection* conn, int clientFd, int backendFd);
+    void armPoolSweep();
+    void armHealthTick(HealthMonitor& monitor);
+    void armStatsReport();
+    void parkConnection(std::shared_ptr<IConnection> conn);
+    void onParkedClientEvent(Event e, int clientFd, ConnectionPool::WaitTicket ticket,
+                             std::weak_ptr<IConnection> weak);
+    void startBackend(std::shared_ptr<IConnection> conn, int pooledFd);
+    void wakeup();
+    void drainTasks();
     std::unique_ptr<IEventLoop> m_Loop;
-    std::unordered_map<int, std::shared_ptr<IConnection>> m_Connections;
+    // Dense fd-indexed connection table; the slot owns the connection, the hot path
+    // dispatches through the raw pointer without touching the refcount.
+    std::vector<Slot> m_Slots;
+    std::unordered_map<int, FdHandler> m_Handlers;
     ConnectionPool& m_ConnectionPool;
     ILogger& m_Logger;
-    std::atomic<bool> m_Running;
+    std::atomic<bool> m_Running{false};
+    std::atomic<bool> m_StopRequested{false};
+    MpscQueue<Task> m_Mailbox;
+    int m_WakeFd{-1};
+    int m_WakeWriteFd{-1};
+    std::atomic<bool> m_WakePending{false};
     std::chrono::seconds m_IdleTimeout{0};
-    std::thread m_IdleThread;
-    std::atomic<bool> m_StopIdleMonitor{false};
+    std::chrono::milliseconds m_ConnectTimeout{0};
+    std::chrono::milliseconds m_PoolSweepInterval{0};
+    std::chrono::milliseconds m_StatsInterval{0};
 };
@@ -0,0 +1,44 @@
+#pragma once
+#include "reactor.h"
+#include "event_loop_factory.h"
+#include "interfaces/ILogger.h"
+#include "connection_pool.h"
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
+
+// Owns N reactors, each with its own event loop, connection table and thread.
+class ReactorGroup {
+public:
+    using LoopFactory = std::function<std::unique_ptr<IEventLoop>()>;
+
+    ReactorGroup(size_t count,
+                 ILogger& logger,
+                 ConnectionPool& connectionPool,
+                 LoopFactory loopFactory = nullptr);
+    ~ReactorGroup();
+
+    void start();
+    void stop();
+
+    // Round-robins new connections across the reactors.
+    Reactor& next();
+    Reactor& at(size_t index) { return *m_Reactors[index]; }
+    size_t size() const noexcept { return m_Reactors.size(); }
+    void setIdleTimeout(std::chrono::seconds timeout);
+    void setConnectTimeout(std::chrono::milliseconds timeout);
+    void enableStatsReport(std::chrono::milliseconds interval);
+
+    // 0 means one reactor per available CPU (affinity mask and cgroup quota).
+    static size_t resolveThreadCount(int configured);
+    static size_t availableCpus();
+
+private:
+    std::vector<std::unique_ptr<Reactor>> m_Reactors;
+    std::vector<std::thread> m_Threads;
+    std::atomic<size_t> m_NextIndex{0};
+    std::atomic<bool> m_Started{false};
+    ILogger& m_Logger;
+};
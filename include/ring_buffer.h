@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <sys/uio.h>
+
+// Fixed-capacity byte ring. Bytes are never shifted: writers fill the free spans and
+// readers drain the readable spans in place, so a partial send only moves an index.
+class RingBuffer {
+public:
+    // With ownStorage=false the ring starts without memory; attach() a block of at
+    // least `capacity` bytes (e.g. from a BufferPool) before use.
+    explicit RingBuffer(size_t capacity, bool ownStorage = true);
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    size_t capacity() const noexcept { return m_Capacity; }
+    size_t size() const noexcept { return m_Size; }
+    size_t available() const noexcept { return m_Capacity - m_Size; }
+    bool empty() const noexcept { return m_Size == 0; }
+    bool full() const noexcept { return m_Size == m_Capacity; }
+    bool hasStorage() const noexcept { return m_Data != nullptr; }
+
+    void attach(char* storage) noexcept;
+    // Gives borrowed storage back (contents are dropped); nullptr if the ring owns it.
+    char* detach() noexcept;
+
+    // Fill `spans` with up to two regions in order; returns how many are non-empty.
+    int readableSpans(iovec (&spans)[2]) const noexcept;
+    int writableSpans(iovec (&spans)[2]) noexcept;
+
+    // Account for bytes placed into the writable spans / taken from the readable spans.
+    void commitWrite(size_t n) noexcept;
+    void consume(size_t n) noexcept;
+
+    size_t write(const void* data, size_t len) noexcept;
+    size_t read(void* out, size_t len) noexcept;
+    void clear() noexcept;
+
+private:
+    std::unique_ptr<char[]> m_Owned;
+    char* m_Data;
+    size_t m_Capacity;
+    size_t m_Head{0};   // first readable byte
+    size_t m_Size{0};
+};
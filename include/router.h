@@ -1,19 +1,39 @@
 #pragma once
 #include "backend_pool.h"
+#include "maglev_table.h"
+#include <netinet/in.h>
+#include <memory>
 #include <string>
 
 enum class RoutingAlgorithm {
     RoundRobin,
     LeastConnections,
-    Random
+    Random,
+    // Two random backends, the one with the lower BackendStats::cost wins.
+    PowerOfTwoChoices,
+    // Maglev table keyed by client IP: a client keeps landing on the same backend.
+    ConsistentHash
 };
 
+// Config name ("roundRobin", "leastConnections", "powerOfTwoChoices", "consistentHash")
+// to algorithm; throws on anything else.
+RoutingAlgorithm parseRoutingAlgorithm(const std::string& name);
+
+// Affinity key for a client: its IP only, so every connection from it shares the key.
+uint64_t clientAffinityKey(const sockaddr_in& client);
+
 class Router {
 public:
     explicit Router(BackendPool& backendPool, RoutingAlgorithm algorithm = RoutingAlgorithm::RoundRobin);
-    virtual BackendConfig selectBackend();
+    // `clientKey` (see clientAffinityKey) is only read by ConsistentHash.
+    virtual const Backend& selectBackend(uint64_t clientKey = 0);
 
 private:
+    const Backend& leastConnections();
+    const Backend& powerOfTwoChoices();
+    const Backend& consistentHash(uint64_t clientKey);
+
     BackendPool& m_BackendPool;
     RoutingAlgorithm m_Algorithm;
+    std::unique_ptr<MaglevTable> m_Maglev;   // built once, for ConsistentHash only
 };
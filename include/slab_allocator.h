@@ -0,0 +1,146 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Fixed-size block pool. Blocks are carved out of slabs that are never returned to
+// the OS, so steady-state allocation is a free-list pop. Each thread (in practice
+// each reactor and the acceptor) keeps a private free list; only batches of
+// BATCH blocks move between threads through the shared list, under a mutex.
+template <size_t BlockSize, size_t BlockAlign>
+class BlockPool {
+public:
+    static constexpr size_t BLOCKS_PER_SLAB = 64;
+    static constexpr size_t BATCH = 32;
+
+    static BlockPool& instance() {
+        // Leaked on purpose: thread caches may hand blocks back after static destruction.
+        static BlockPool* pool = new BlockPool();
+        return *pool;
+    }
+
+    void* allocate() {
+        LocalCache& cache = local();
+        if (!cache.head && !refill(cache))
+            allocateSlab(cache);
+        FreeNode* node = cache.head;
+        cache.head = node->next;
+        --cache.count;
+        return node;
+    }
+
+    void deallocate(void* p) noexcept {
+        LocalCache& cache = local();
+        auto* node = static_cast<FreeNode*>(p);
+        node->next = cache.head;
+        cache.head = node;
+        if (++cache.count >= 2 * BATCH)
+            spill(cache, BATCH);
+    }
+
+    size_t slabCount() {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Slabs.size();
+    }
+
+private:
+    static constexpr size_t STRIDE =
+        (std::max(BlockSize, sizeof(void*)) + BlockAlign - 1) / BlockAlign * BlockAlign;
+
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    struct LocalCache {
+        FreeNode* head = nullptr;
+        size_t count = 0;
+        ~LocalCache() { BlockPool::instance().spill(*this, count); }
+    };
+
+    BlockPool() = default;
+
+    static LocalCache& local() {
+        thread_local LocalCache cache;
+        return cache;
+    }
+
+    bool refill(LocalCache& cache) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Batches.empty())
+            return false;
+        cache.head = m_Batches.back().first;
+        cache.count = m_Batches.back().second;
+        m_Batches.pop_back();
+        return true;
+    }
+
+    // Hands n blocks to the shared list. The most recently freed block stays local
+    // (it is the one most likely to still be in cache) unless everything goes.
+    void spill(LocalCache& cache, size_t n) noexcept {
+        if (n == 0)
+            return;
+        FreeNode** link = n < cache.count ? &cache.head->next : &cache.head;
+        FreeNode* first = *link;
+        FreeNode* last = first;
+        for (size_t i = 1; i < n; ++i)
+            last = last->next;
+        *link = last->next;
+        cache.count -= n;
+        last->next = nullptr;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Batches.emplace_back(first, n);
+    }
+
+    void allocateSlab(LocalCache& cache) {
+        auto* slab = static_cast<char*>(::operator new(STRIDE * BLOCKS_PER_SLAB, std::align_val_t(BlockAlign)));
+        for (size_t i = BLOCKS_PER_SLAB; i-- > 0;) {
+            auto* node = reinterpret_cast<FreeNode*>(slab + i * STRIDE);
+            node->next = cache.head;
+            cache.head = node;
+        }
+        cache.count += BLOCKS_PER_SLAB;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Slabs.push_back(slab);
+    }
+
+    std::mutex m_Mutex;
+    std::vector<std::pair<FreeNode*, size_t>> m_Batches;
+    std::vector<char*> m_Slabs;
+};
+
+// Standard allocator over BlockPool, meant for std::allocate_shared: the object and
+// its control block share one recycled block.
+template <typename T>
+struct SlabAllocator {
+    using value_type = T;
+
+    SlabAllocator() noexcept = default;
+    template <typename U>
+    SlabAllocator(const SlabAllocator<U>&) noexcept {}
+
+    using Pool = BlockPool<sizeof(T), alignof(T)>;
+
+    T* allocate(size_t n) {
+        if (n != 1)
+            return std::allocator<T>().allocate(n);
+        return static_cast<T*>(Pool::instance().allocate());
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        if (n != 1) {
+            std::allocator<T>().deallocate(p, n);
+            return;
+        }
+        Pool::instance().deallocate(p);
+    }
+
+    template <typename U>
+    bool operator==(const SlabAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const SlabAllocator<U>&) const noexcept { return false; }
+};
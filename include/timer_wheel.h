@@ -0,0 +1,68 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+using TimerId = uint64_t;
+constexpr TimerId INVALID_TIMER_ID = 0;
+
+// Hashed timing wheel: O(1) schedule and cancel, each tick only visits one slot.
+// Timers further out than one revolution stay in their slot until their tick comes
+// round. Not thread-safe; owned and driven by a single event loop.
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+
+    explicit TimerWheel(std::chrono::milliseconds tick = std::chrono::milliseconds(10),
+                        size_t slots = 512,
+                        Clock::time_point start = Clock::now());
+
+    // `delay` counts from `now`, not from the last advance(): a loop that spent a while
+    // dispatching must not have its new timers fire early.
+    TimerId schedule(std::chrono::milliseconds delay, Callback callback, Clock::time_point now = Clock::now());
+    bool cancel(TimerId id);
+
+    // Fires every timer that is due at `now`; returns how many ran.
+    size_t advance(Clock::time_point now = Clock::now());
+
+    // How long a poller may sleep before the next occupied tick, capped at maxMs
+    // (a negative maxMs means "no cap").
+    int nextTimeoutMs(int maxMs, Clock::time_point now = Clock::now()) const;
+
+    size_t size() const noexcept { return m_Active; }
+    bool empty() const noexcept { return m_Active == 0; }
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    enum class State : uint8_t { Free, Scheduled, Firing };
+
+    struct Node {
+        Callback callback;
+        uint64_t expiresTick = 0;
+        uint32_t generation = 1;
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+        State state = State::Free;
+    };
+
+    uint64_t tickAt(Clock::time_point t) const;
+    uint32_t allocateNode();
+    void releaseNode(uint32_t index);
+    void link(uint32_t index);
+    void unlink(uint32_t index);
+    static TimerId makeId(uint32_t index, uint32_t generation) {
+        return (static_cast<uint64_t>(generation) << 32) | index;
+    }
+
+    std::chrono::milliseconds m_Tick;
+    Clock::time_point m_Start;
+    uint64_t m_CurrentTick{0};
+    std::vector<uint32_t> m_Slots;
+    std::vector<Node> m_Nodes;
+    std::vector<uint32_t> m_FreeNodes;
+    std::vector<uint32_t> m_Due;
+    size_t m_Active{0};
+};
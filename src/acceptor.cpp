@@ -1,10 +1,12 @@
 #include "acceptor.h"
 #include "connection.h"
+#include "slab_allocator.h"
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <cstring>
 #include <iostream>
 
@@ -16,6 +18,7 @@ Acceptor::Acceptor(const ListenConfig& listenConfig,
     : m_Host(listenConfig.host),
       m_Port(listenConfig.port),
       m_Backlog(listenConfig.backlog),
+      m_ReusePort(listenConfig.reusePort),
       m_Router(router),
       m_Logger(logger),
       m_ConnectionPool(connectionPool),
@@ -26,6 +29,8 @@ Acceptor::Acceptor(const ListenConfig& listenConfig,
 
 Acceptor::~Acceptor() {
     stop();
+    if (m_Loop && m_RetryTimer != INVALID_TIMER_ID)
+        m_Loop->cancelTimer(m_RetryTimer);
     closeListeningSocket();
 }
 
@@ -38,21 +43,31 @@ void Acceptor::setupListeningSocket() {
 
     int opt = 1;
     setsockopt(m_ServerFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (m_ReusePort && setsockopt(m_ServerFd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("setsockopt(SO_REUSEPORT)");
+        closeListeningSocket();
+        throw std::runtime_error("Failed to enable SO_REUSEPORT on listening socket");
+    }
 
     fcntl(m_ServerFd, F_SETFL, O_NONBLOCK);
 
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
     addr.sin_port = htons(m_Port);
-    addr.sin_addr.s_addr = inet_addr(m_Host.c_str());
+    if (inet_pton(AF_INET, m_Host.c_str(), &addr.sin_addr) != 1) {
+        closeListeningSocket();
+        throw std::runtime_error("Invalid listen address: " + m_Host);
+    }
 
     if (::bind(m_ServerFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
         perror("bind");
+        closeListeningSocket();
         throw std::runtime_error("Failed to bind listening socket");
     }
 
     if (listen(m_ServerFd, m_Backlog) < 0) {
         perror("listen");
+        closeListeningSocket();
         throw std::runtime_error("Failed to listen on socket");
     }
 
@@ -78,7 +93,27 @@ void Acceptor::stop() {
 
 void Acceptor::acceptLoop() {
     m_Logger.logInfo("Entering accept loop");
+    pollfd pfd{m_ServerFd, POLLIN, 0};
     while (m_Running) {
+        if (acceptPending() > 0)
+            continue;
+        if (m_AcceptStalled) {
+            // The listener stays readable: back off instead of spinning on the error.
+            std::this_thread::sleep_for(ACCEPT_RETRY_DELAY);
+            continue;
+        }
+
+        // Block until the listener is readable instead of sleeping between retries;
+        // the timeout only bounds how long stop() waits for this thread.
+        pfd.revents = 0;
+        ::poll(&pfd, 1, 100);
+    }
+}
+
+int Acceptor::acceptPending() {
+    int accepted = 0;
+    m_AcceptStalled = false;
+    for (;;) {
         sockaddr_in clientAddr{};
         socklen_t len = sizeof(clientAddr);
         
@@ -95,35 +130,65 @@ void Acceptor::acceptLoop() {
         #endif
         
         if (clientFd < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                continue;
-            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
 
-            if (errno == EINTR)
+            if (errno == EINTR || errno == ECONNABORTED)
                 continue;
-            m_AcceptErrorCount++;
-            perror("accept4");
-            continue;
+            // Out of fds or buffers: the backlog is still full, but an edge-triggered
+            // listener won't report it again until another client arrives.
+            logAcceptError(errno);
+            m_AcceptStalled = true;
+            scheduleRetry();
+            break;
         }
 
-        char clientIp[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &clientAddr.sin_addr, clientIp, sizeof(clientIp));
-        int clientPort = ntohs(clientAddr.sin_port);
+        ++accepted;
+        handleAccepted(clientFd, clientAddr);
+    }
+    return accepted;
+}
 
-        std::string clientStr = std::string(clientIp) + ":" + std::to_string(clientPort);
-        m_Logger.logInfo("Accepted connection from " + clientStr);
+void Acceptor::scheduleRetry() {
+    if (!m_Loop || m_RetryTimer != INVALID_TIMER_ID)
+        return;
+    m_RetryTimer = m_Loop->addTimer(ACCEPT_RETRY_DELAY, [this]() {
+        m_RetryTimer = INVALID_TIMER_ID;
+        acceptPending();
+    });
+}
 
-        try {
-            auto backend = m_Router.selectBackend();
-            int backendFd = m_ConnectionPool.acquire(backend);
+// At most one line per interval, however fast accept() keeps failing.
+void Acceptor::logAcceptError(int err) {
+    ++m_AcceptErrorCount;
+    auto now = std::chrono::steady_clock::now();
+    if (now - m_LastAcceptErrorLog < ACCEPT_ERROR_LOG_INTERVAL)
+        return;
+    m_LastAcceptErrorLog = now;
+    m_Logger.logError("accept failed on port " + std::to_string(m_Port) + ": " + strerror(err) + " (" +
+                      std::to_string(m_AcceptErrorCount) + " error(s) since last report); retrying");
+    m_AcceptErrorCount = 0;
+}
 
-            auto conn = std::make_shared<Connection>(clientFd, backendFd, backend, m_Logger);
-            m_OnAcceptCallback(conn, clientFd, backend);
-        } catch (const std::exception& ex) {
-            m_Logger.logError(std::string("Error selecting backend: ") + ex.what());
-            close(clientFd);
-        }
+void Acceptor::handleAccepted(int clientFd, const sockaddr_in& clientAddr) {
+    char clientIp[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &clientAddr.sin_addr, clientIp, sizeof(clientIp));
+    int clientPort = ntohs(clientAddr.sin_port);
+
+    std::string clientStr = std::string(clientIp) + ":" + std::to_string(clientPort);
+    m_Logger.logInfo("Accepted connection from " + clientStr);
+
+    try {
+        const Backend& backend = m_Router.selectBackend(clientAffinityKey(clientAddr));
+
+        // Object and control block come from a recycled slab block: no malloc per accept.
+        // The backend fd (pooled or dialed) is settled by the owning reactor on admission.
+        auto conn = std::allocate_shared<Connection>(SlabAllocator<Connection>(), clientFd, -1, backend,
+                                                     m_Logger, m_ConnectionOptions);
+        m_OnAcceptCallback(conn, clientFd, backend);
+    } catch (const std::exception& ex) {
+        m_Logger.logError(std::string("Error selecting backend: ") + ex.what());
+        close(clientFd);
     }
 }
 
@@ -133,7 +198,3 @@ void Acceptor::closeListeningSocket() {
         m_ServerFd = -1;
     }
 }
-
-void Acceptor::onConnectionClosed(std::shared_ptr<IConnection> conn) {
-    m_ConnectionPool.release(conn->getBackendConfig(), conn->getBackendFd());
-}
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "backend.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <cmath>
+#include <cstring>
+
+static double decayWeight(int64_t elapsedTicks) {
+    if (elapsedTicks <= 0)
+        return 1.0;
+    double elapsed = std::chrono::duration<double>(BackendStats::Clock::duration(elapsedTicks)).count();
+    return std::exp(-elapsed / std::chrono::duration<double>(BackendStats::LATENCY_DECAY).count());
+}
+
+// Lock-free: the stamp and the estimate are updated separately, so two racing samples
+// may both decay from the same stamp. The estimate stays within their range either way.
+void BackendStats::observeLatency(std::chrono::nanoseconds sample, Clock::time_point now) noexcept {
+    double rtt = static_cast<double>(std::max<int64_t>(sample.count(), 0));
+    int64_t stamp = now.time_since_epoch().count();
+    double weight = decayWeight(stamp - latencyStamp.exchange(stamp, std::memory_order_relaxed));
+
+    uint64_t current = latencyNanos.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        double estimate = static_cast<double>(current);
+        next = static_cast<uint64_t>(rtt > estimate ? rtt : estimate * weight + rtt * (1.0 - weight));
+    } while (!latencyNanos.compare_exchange_weak(current, next, std::memory_order_relaxed));
+}
+
+double BackendStats::cost(Clock::time_point now) const noexcept {
+    // Floor of 1us so unmeasured (or fully decayed) backends still compare by load.
+    static constexpr double FLOOR_NANOS = 1000.0;
+    double estimate = static_cast<double>(latencyNanos.load(std::memory_order_relaxed)) *
+                      decayWeight(now.time_since_epoch().count() - latencyStamp.load(std::memory_order_relaxed));
+    return (estimate + FLOOR_NANOS) * (active.load(std::memory_order_relaxed) + 1);
+}
+
+static uint64_t circuitWord(BackendStats::Circuit state, BackendStats::Clock::time_point until) {
+    return static_cast<uint64_t>(until.time_since_epoch().count()) << 2 | static_cast<uint64_t>(state);
+}
+
+static BackendStats::Clock::time_point circuitUntil(uint64_t word) {
+    return BackendStats::Clock::time_point(BackendStats::Clock::duration(static_cast<int64_t>(word >> 2)));
+}
+
+void BackendStats::recordSuccess() noexcept {
+    if (consecutiveFailures.load(std::memory_order_relaxed) != 0)
+        consecutiveFailures.store(0, std::memory_order_relaxed);
+    uint64_t word = circuit.load(std::memory_order_acquire);
+    // Successes from connections that predate an ejection do not cut it short.
+    if (static_cast<Circuit>(word & 3) != Circuit::HalfOpen)
+        return;
+    if (circuit.compare_exchange_strong(word, circuitWord(Circuit::Closed, {}), std::memory_order_acq_rel)) {
+        closedSince.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        if (ejectionBudget)
+            ejectionBudget->release();
+    }
+}
+
+BackendStats::Clock::duration BackendStats::recordFailure(Clock::time_point now) noexcept {
+    if (!outlierPolicy)
+        return {};
+    uint64_t word = circuit.load(std::memory_order_acquire);
+    switch (static_cast<Circuit>(word & 3)) {
+        case Circuit::Open:
+            return {};   // stragglers from before the ejection
+        case Circuit::HalfOpen:
+            return eject(word, now);
+        case Circuit::Closed:
+            break;
+    }
+    uint32_t failures = consecutiveFailures.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (failures < static_cast<uint32_t>(outlierPolicy->consecutiveFailures))
+        return {};
+    return eject(word, now);
+}
+
+// Whoever wins the CAS ejects; racing failures that lose it are already accounted for.
+// A fresh ejection also needs a slot in the pool's budget: without one the backend
+// stays in rotation and its next failure tries again.
+BackendStats::Clock::duration BackendStats::eject(uint64_t expected, Clock::time_point now) noexcept {
+    using std::chrono::milliseconds;
+    uint32_t count = ejections.load(std::memory_order_relaxed);
+    // Back to the base ejection if the backend had a long clean run since the last one.
+    if (static_cast<Circuit>(expected & 3) == Circuit::Closed &&
+        now.time_since_epoch().count() - closedSince.load(std::memory_order_relaxed) >
+            Clock::duration(milliseconds(outlierPolicy->maxEjectionMs)).count())
+        count = 0;
+
+    Clock::duration length = milliseconds(outlierPolicy->baseEjectionMs);
+    Clock::duration longest = milliseconds(outlierPolicy->maxEjectionMs);
+    for (uint32_t i = 0; i < count && length < longest; ++i)
+        length *= 2;
+    length = std::min(length, longest);
+
+    bool fresh = static_cast<Circuit>(expected & 3) == Circuit::Closed;
+    if (fresh && ejectionBudget && !ejectionBudget->tryTake())
+        return {};
+    if (!circuit.compare_exchange_strong(expected, circuitWord(Circuit::Open, now + length),
+                                         std::memory_order_acq_rel)) {
+        if (fresh && ejectionBudget)
+            ejectionBudget->release();
+        return {};
+    }
+    ejections.store(count + 1, std::memory_order_relaxed);
+    consecutiveFailures.store(0, std::memory_order_relaxed);
+    return length;
+}
+
+bool BackendStats::claimTrial(uint64_t word, Clock::time_point now) noexcept {
+    if (now < circuitUntil(word))
+        return false;
+    return circuit.compare_exchange_strong(word, circuitWord(Circuit::HalfOpen, now + TRIAL_TIMEOUT),
+                                           std::memory_order_acq_rel);
+}
+
+Backend Backend::resolve(const BackendConfig& config, BackendId id) {
+    Backend backend;
+    static_cast<BackendConfig&>(backend) = config;
+    backend.id = id;
+    backend.name = config.host + ":" + std::to_string(config.port);
+
+    auto* v4 = reinterpret_cast<sockaddr_in*>(&backend.addr);
+    auto* v6 = reinterpret_cast<sockaddr_in6*>(&backend.addr);
+    if (inet_pton(AF_INET, config.host.c_str(), &v4->sin_addr) == 1) {
+        v4->sin_family = AF_INET;
+        v4->sin_port = htons(config.port);
+        backend.addrLen = sizeof(sockaddr_in);
+    } else if (inet_pton(AF_INET6, config.host.c_str(), &v6->sin6_addr) == 1) {
+        v6->sin6_family = AF_INET6;
+        v6->sin6_port = htons(config.port);
+        backend.addrLen = sizeof(sockaddr_in6);
+    } else {
+        // A hostname: resolved here, once, rather than on every connect.
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        std::memset(&backend.addr, 0, sizeof(backend.addr));
+        if (getaddrinfo(config.host.c_str(), std::to_string(config.port).c_str(), &hints, &result) == 0 && result) {
+            std::memcpy(&backend.addr, result->ai_addr, result->ai_addrlen);
+            backend.addrLen = static_cast<socklen_t>(result->ai_addrlen);
+        }
+        if (result)
+            freeaddrinfo(result);
+    }
+    return backend;
+}
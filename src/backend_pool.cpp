@@ -1,11 +1,101 @@
 #include "backend_pool.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
 
 BackendPool::BackendPool(const std::vector<BackendConfig>& backends)
-    : m_Backends(backends) {}
+    : m_Backends(backends),
+      m_Stats(std::make_unique<BackendStats[]>(backends.size())),
+      m_Healthy(std::make_unique<std::atomic<uint64_t>[]>((backends.size() + 63) / 64)),
+      m_HealthyCount(backends.size())
+{
+    for (size_t word = 0; word * 64 < backends.size(); ++word) {
+        size_t bits = std::min<size_t>(backends.size() - word * 64, 64);
+        m_Healthy[word].store(bits == 64 ? ~uint64_t{0} : (uint64_t{1} << bits) - 1, std::memory_order_relaxed);
+    }
+    m_Interned.reserve(backends.size());
+    for (size_t i = 0; i < backends.size(); ++i) {
+        m_Interned.push_back(Backend::resolve(backends[i], static_cast<BackendId>(i)));
+        m_Interned.back().stats = &m_Stats[i];
+    }
+    buildSchedule();
+}
+
+// nginx's smooth weighted round robin, run once over a full period: every step each
+// backend gains its weight, the richest is picked and pays back the total.
+void BackendPool::buildSchedule() {
+    std::vector<uint64_t> weights;
+    weights.reserve(m_Backends.size());
+    uint64_t divisor = 0;
+    for (const auto& backend : m_Backends) {
+        weights.push_back(std::max<uint64_t>(backend.weight, 1));
+        divisor = std::gcd(divisor, weights.back());
+    }
+    uint64_t total = 0;
+    for (auto& weight : weights)
+        total += weight /= std::max<uint64_t>(divisor, 1);
+    if (total > MAX_SCHEDULE) {
+        uint64_t scaled = 0;
+        for (auto& weight : weights)
+            scaled += weight = std::max<uint64_t>(weight * MAX_SCHEDULE / total, 1);
+        total = scaled;
+    }
 
-BackendConfig BackendPool::getNextBackend() {
+    m_Schedule.clear();
+    m_Schedule.reserve(total);
+    std::vector<int64_t> current(weights.size(), 0);
+    for (uint64_t step = 0; step < total; ++step) {
+        size_t best = 0;
+        for (size_t i = 0; i < weights.size(); ++i) {
+            current[i] += static_cast<int64_t>(weights[i]);
+            if (current[i] > current[best])
+                best = i;
+        }
+        current[best] -= static_cast<int64_t>(total);
+        m_Schedule.push_back(static_cast<BackendId>(best));
+    }
+}
+
+const Backend& BackendPool::getNextBackend() {
+    if (m_Schedule.empty())
+        throw std::runtime_error("No backends configured");
     size_t index = m_CurrentIndex.fetch_add(1, std::memory_order_relaxed);
-    return m_Backends[index % m_Backends.size()];
+    BackendId id = m_Schedule[index % m_Schedule.size()];
+    if (admits(id) || healthyCount() == 0)
+        return m_Interned[id];
+
+    // A down or ejected backend's turn goes to a pick scanned locally from a point
+    // scattered by the turn's index, so the shared cursor moves once per client and the
+    // skipped turns are shared out by weight rather than all landing on its neighbour.
+    size_t start = static_cast<size_t>((uint64_t{index} * 0x9E3779B97F4A7C15ull) >> 32);
+    for (size_t tries = 0; tries < m_Schedule.size(); ++tries) {
+        BackendId next = m_Schedule[(start + tries) % m_Schedule.size()];
+        if (next != id && admits(next))
+            return m_Interned[next];
+    }
+    return m_Interned[id];   // nothing in rotation: fail open
+}
+
+void BackendPool::enableOutlierDetection(const OutlierDetectionConfig& config) {
+    m_OutlierPolicy = config;
+    m_EjectionBudget.limit = std::max<uint32_t>(
+        static_cast<uint32_t>(m_Interned.size() * static_cast<size_t>(config.maxEjectionPercent) / 100), 1);
+    for (size_t i = 0; i < m_Interned.size(); ++i) {
+        m_Stats[i].outlierPolicy = &m_OutlierPolicy;
+        m_Stats[i].ejectionBudget = &m_EjectionBudget;
+    }
+}
+
+void BackendPool::setHealthy(BackendId id, bool healthy) noexcept {
+    uint64_t bit = uint64_t{1} << (id % 64);
+    uint64_t before = healthy ? m_Healthy[id / 64].fetch_or(bit, std::memory_order_relaxed)
+                              : m_Healthy[id / 64].fetch_and(~bit, std::memory_order_relaxed);
+    if (bool(before & bit) != healthy) {
+        if (healthy)
+            m_HealthyCount.fetch_add(1, std::memory_order_relaxed);
+        else
+            m_HealthyCount.fetch_sub(1, std::memory_order_relaxed);
+    }
 }
 
 const std::vector<BackendConfig>& BackendPool::getAllBackends() const {
@@ -0,0 +1,87 @@
+#include "buffer_pool.h"
+#include <sys/mman.h>
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+BufferPool::BufferPool(size_t chunkSize, size_t memoryBudget, bool hugePages)
+    : m_ChunkSize((std::max<size_t>(chunkSize, 64) + 63) / 64 * 64)
+{
+    m_ChunkCount = memoryBudget / m_ChunkSize;
+    if (m_ChunkCount == 0)
+        throw std::runtime_error("Buffer pool budget is smaller than one chunk");
+    if (m_ChunkCount >= NIL)
+        m_ChunkCount = NIL - 1;
+    m_ArenaSize = (m_ChunkCount * m_ChunkSize + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+    void* arena = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (hugePages) {
+        // No MAP_NORESERVE here: the reservation is what makes mmap fail up front when
+        // the hugetlb pool is too small, instead of SIGBUS on first touch.
+        arena = mmap(nullptr, m_ArenaSize, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        m_HugeTlb = arena != MAP_FAILED;
+    }
+#endif
+    if (arena == MAP_FAILED) {
+        // No reserved hugetlbfs pages: plain mapping, and ask for transparent huge pages.
+        arena = mmap(nullptr, m_ArenaSize, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (arena == MAP_FAILED)
+            throw std::runtime_error(std::string("Failed to map buffer pool arena: ") + strerror(errno));
+#ifdef MADV_HUGEPAGE
+        if (hugePages)
+            madvise(arena, m_ArenaSize, MADV_HUGEPAGE);
+#endif
+    }
+    m_Arena = static_cast<char*>(arena);
+    m_Next = std::make_unique<std::atomic<uint32_t>[]>(m_ChunkCount);
+}
+
+BufferPool::~BufferPool() {
+    if (m_Arena)
+        munmap(m_Arena, m_ArenaSize);
+}
+
+char* BufferPool::acquire() noexcept {
+    uint64_t head = m_FreeHead.load(std::memory_order_acquire);
+    while (static_cast<uint32_t>(head) != NIL) {
+        uint32_t index = static_cast<uint32_t>(head);
+        uint32_t next = m_Next[index].load(std::memory_order_relaxed);
+        uint64_t replacement = ((head >> 32) + 1) << 32 | next;
+        if (m_FreeHead.compare_exchange_weak(head, replacement, std::memory_order_acq_rel,
+                                             std::memory_order_acquire)) {
+            m_InUse.fetch_add(1, std::memory_order_relaxed);
+            return m_Arena + static_cast<size_t>(index) * m_ChunkSize;
+        }
+    }
+
+    // Free list empty: carve a never-used chunk, if the budget allows.
+    size_t carved = m_Carved.load(std::memory_order_relaxed);
+    while (carved < m_ChunkCount) {
+        if (m_Carved.compare_exchange_weak(carved, carved + 1, std::memory_order_relaxed)) {
+            m_InUse.fetch_add(1, std::memory_order_relaxed);
+            return m_Arena + carved * m_ChunkSize;
+        }
+    }
+    return nullptr;
+}
+
+void BufferPool::release(char* chunk) noexcept {
+    if (!chunk)
+        return;
+    uint32_t index = static_cast<uint32_t>(static_cast<size_t>(chunk - m_Arena) / m_ChunkSize);
+    uint64_t head = m_FreeHead.load(std::memory_order_relaxed);
+    uint64_t replacement;
+    do {
+        m_Next[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        replacement = ((head >> 32) + 1) << 32 | index;
+    } while (!m_FreeHead.compare_exchange_weak(head, replacement, std::memory_order_release,
+                                               std::memory_order_relaxed));
+    m_InUse.fetch_sub(1, std::memory_order_relaxed);
+}
@@ -2,6 +2,7 @@
 #include <nlohmann/json.hpp>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 using json = nlohmann::json;
 using namespace std;
 
@@ -54,10 +55,71 @@ void ConfigManager::validateConfig() {
         if (backend.host.empty()) {
             throw runtime_error("Configuration error: Backend host cannot be empty.");
         }
+        if (backend.weight == 0) {
+            throw runtime_error("Configuration error: Backend weight must be positive.");
+        }
     }
     if (config.reactor.threads < 0) {
         throw runtime_error("Configuration error: Reactor threads cannot be negative.");
     }
+    if (config.reactor.idleTimeoutSeconds < 0 || config.reactor.connectTimeoutMs < 0) {
+        throw runtime_error("Configuration error: Reactor timeouts cannot be negative.");
+    }
+    if (config.reactor.eventLoop != "default" &&
+        config.reactor.eventLoop != "epoll" &&
+        config.reactor.eventLoop != "io_uring" &&
+        config.reactor.eventLoop != "kqueue") {
+        throw runtime_error("Configuration error: Invalid reactor event loop specified.");
+    }
+    if (config.routing.algorithm != "roundRobin" &&
+        config.routing.algorithm != "leastConnections" &&
+        config.routing.algorithm != "powerOfTwoChoices" &&
+        config.routing.algorithm != "consistentHash") {
+        throw runtime_error("Configuration error: Invalid routing algorithm specified.");
+    }
+    if (config.healthCheck.intervalMs <= 0 || config.healthCheck.timeoutMs <= 0) {
+        throw runtime_error("Configuration error: Health check interval and timeout must be positive.");
+    }
+    if (config.healthCheck.healthyThreshold <= 0 || config.healthCheck.unhealthyThreshold <= 0) {
+        throw runtime_error("Configuration error: Health check thresholds must be positive.");
+    }
+    if (config.outlierDetection.consecutiveFailures <= 0) {
+        throw runtime_error("Configuration error: Outlier detection failure threshold must be positive.");
+    }
+    if (config.outlierDetection.baseEjectionMs <= 0 ||
+        config.outlierDetection.maxEjectionMs < config.outlierDetection.baseEjectionMs) {
+        throw runtime_error("Configuration error: Outlier detection needs 0 < baseEjectionMs <= maxEjectionMs.");
+    }
+    if (config.outlierDetection.maxEjectionPercent < 1 || config.outlierDetection.maxEjectionPercent > 100) {
+        throw runtime_error("Configuration error: Outlier detection maxEjectionPercent must be between 1 and 100.");
+    }
+    if (config.reactor.connectionReadBuffer == 0 || config.reactor.connectionWriteBuffer == 0) {
+        throw runtime_error("Configuration error: Connection buffer sizes must be positive.");
+    }
+    if (config.bufferPool.memoryBudgetBytes != 0 &&
+        config.bufferPool.memoryBudgetBytes <
+            std::max(config.reactor.connectionReadBuffer, config.reactor.connectionWriteBuffer)) {
+        throw runtime_error("Configuration error: Buffer pool budget must hold at least one connection buffer.");
+    }
+    if (config.connectionPool.minIdle > config.connectionPool.maxIdle ||
+        config.connectionPool.maxIdle > config.connectionPool.maxConnectionsPerBackend) {
+        throw runtime_error("Configuration error: Connection pool needs minIdle <= maxIdle <= maxConnectionsPerBackend.");
+    }
+    if (config.connectionPool.maintenanceIntervalMs <= 0) {
+        throw runtime_error("Configuration error: Connection pool maintenance interval must be positive.");
+    }
+    if (config.connectionPool.idleTtlMs <= 0 || config.connectionPool.reapIntervalMs <= 0) {
+        throw runtime_error("Configuration error: Connection pool idle TTL and reap interval must be positive.");
+    }
+    if (config.connectionPool.waitQueueDepth > 0 && config.connectionPool.maxActivePerBackend == 0) {
+        throw runtime_error("Configuration error: Connection pool wait queue requires maxActivePerBackend.");
+    }
+    if (config.connectionPool.waitTimeoutMs <= 0) {
+        throw runtime_error("Configuration error: Connection pool wait timeout must be positive.");
+    }
+    if (config.reactor.forwarding != "copy" && config.reactor.forwarding != "splice") {
+        throw runtime_error("Configuration error: Invalid reactor forwarding mode specified.");
+    }
     if (config.logging.level != "debug" &&
         config.logging.level != "info" &&
         config.logging.level != "warn" &&
@@ -1,160 +1,698 @@
 #include "connection.h"
+#include "event_loop.h"
+#include "connection_pool.h"
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <sys/fcntl.h>
+#include <fcntl.h>
+#include <vector>
 
-Connection::Connection(int clientFd, int backendFd, const BackendConfig& backend, ILogger& logger)
+#ifdef __linux__
+static constexpr size_t SPLICE_CHUNK = 65536;
+#endif
+static constexpr std::chrono::milliseconds MEMORY_RETRY_DELAY{20};
+
+// One per reactor thread; only ever used within a single call.
+static char* scratchBuffer(size_t size) {
+    thread_local std::vector<char> scratch;
+    if (scratch.size() < size)
+        scratch.resize(size);
+    return scratch.data();
+}
+
+static size_t ringCapacity(size_t configured, const BufferPool* pool) {
+    return pool ? std::min(configured, pool->chunkSize()) : configured;
+}
+
+Connection::Connection(int clientFd, int backendFd, const Backend& backend, ILogger& logger,
+                       const ConnectionOptions& options)
     : m_ClientFd(clientFd),
       m_BackendFd(backendFd),
       m_Backend(backend),
       m_Logger(logger),
       m_Connected(false),
-      m_LastActivity(std::chrono::steady_clock::now())
+      m_LastActivity(std::chrono::steady_clock::now()),
+      m_Options(options),
+      m_Upstream(ringCapacity(options.readBufferSize, options.bufferPool)),
+      m_Downstream(ringCapacity(options.writeBufferSize, options.bufferPool))
       {
+#ifndef __linux__
+        m_Options.useSplice = false;
+#endif
+        // Counted for the whole client session, parked and connecting included, so the
+        // router sees a burst of accepts before their backend connects complete.
+        if (m_Backend.stats)
+            m_Backend.stats->active.fetch_add(1, std::memory_order_relaxed);
         m_Logger.logDebug("Connection created: clientFd=" + std::to_string(clientFd) +
                       ", backendFd=" + std::to_string(backendFd));
       }
 
 Connection::~Connection() {
     closeAll();
+    if (m_Backend.stats)
+        m_Backend.stats->active.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// Never blocks: the socket is non-blocking before connect(), so a slow backend leaves
+// the connect in progress and the reactor completes it on writability (bounded by its
+// connect deadline). A backend fd handed in from the pool is already connected.
+void Connection::adoptBackendFd(int fd) {
+    if (m_BackendFd < 0)
+        m_BackendFd = fd;
 }
 
 bool Connection::connectToBackend() {
-    m_Logger.logInfo("Connecting to backend " + m_Backend.host + ":" + std::to_string(m_Backend.port));
     if (m_Connected)
         return true;
+    if (m_BackendFd >= 0) {
+        int flags = fcntl(m_BackendFd, F_GETFL, 0);
+        fcntl(m_BackendFd, F_SETFL, flags | O_NONBLOCK);
+        m_Connected = true;
+        // A live pooled connection settles a half-open trial as surely as a fresh connect.
+        if (m_Backend.stats)
+            m_Backend.stats->recordSuccess();
+        m_Logger.logInfo("Reusing pooled connection to backend " + m_Backend.name);
+        return true;
+    }
+    if (!m_Backend.isResolved()) {
+        m_Logger.logError("Backend " + m_Backend.name + " has no resolved address");
+        return false;
+    }
 
-    m_BackendFd = socket(AF_INET, SOCK_STREAM, 0);
+    m_Logger.logInfo("Connecting to backend " + m_Backend.name);
+#ifdef SOCK_NONBLOCK
+    m_BackendFd = socket(m_Backend.addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+#else
+    m_BackendFd = socket(m_Backend.addr.ss_family, SOCK_STREAM, 0);
+    if (m_BackendFd >= 0)
+        fcntl(m_BackendFd, F_SETFL, fcntl(m_BackendFd, F_GETFL, 0) | O_NONBLOCK);
+#endif
     if (m_BackendFd < 0) {
-        perror("socket");
+        m_Logger.logError(std::string("Failed to create backend socket (") + strerror(errno) + ")");
         return false;
     }
 
-    sockaddr_in backendAddr{};
-    backendAddr.sin_family = AF_INET;
-    backendAddr.sin_port = htons(m_Backend.port);
-    inet_pton(AF_INET, m_Backend.host.c_str(), &backendAddr.sin_addr);
-
-    int result = connect(m_BackendFd, reinterpret_cast<sockaddr*>(&backendAddr), sizeof(backendAddr));
+    int result;
+    while ((result = connect(m_BackendFd, reinterpret_cast<const sockaddr*>(&m_Backend.addr),
+                             m_Backend.addrLen)) < 0 && errno == EINTR) {}
 
     if (result < 0) {
         if (errno == EINPROGRESS) {
+            m_ConnectStart = std::chrono::steady_clock::now();
             m_Logger.logInfo("Backend connection in progress (non-blocking)");
         } else {
-            m_Logger.logError("Failed to connect to backend " + m_Backend.host + ":" + std::to_string(m_Backend.port) +
-                              " (" + strerror(errno) + ")");
+            m_Logger.logError("Failed to connect to backend " + m_Backend.name + " (" + strerror(errno) + ")");
             close(m_BackendFd);
+            m_BackendFd = -1;
+            noteBackendFailure();
             return false;
         }
     } else {
-        m_Logger.logInfo("Connected immediately to backend " + m_Backend.host + ":" + std::to_string(m_Backend.port));
+        m_Logger.logInfo("Connected immediately to backend " + m_Backend.name);
         m_Connected = true;
+        if (m_Backend.stats)
+            m_Backend.stats->recordSuccess();
     }
+    return true;
+}
+void Connection::setConnected(bool connected) {
+    if (connected && !m_Connected && m_Backend.stats && m_ConnectStart != std::chrono::steady_clock::time_point{}) {
+        auto now = std::chrono::steady_clock::now();
+        m_Backend.stats->observeLatency(now - m_ConnectStart, now);
+        m_Backend.stats->recordSuccess();
+    }
+    m_ConnectStart = {};
+    m_Connected = connected;
+}
+
+void Connection::noteBackendFailure() {
+    if (!m_Backend.stats)
+        return;
+    auto ejection = m_Backend.stats->recordFailure();
+    if (ejection.count() > 0)
+        m_Logger.logError("Ejecting backend " + m_Backend.name + " for " +
+                          std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(ejection).count()) +
+                          "ms after repeated failures");
+}
 
-    int flags = fcntl(m_BackendFd, F_GETFL, 0);
-    fcntl(m_BackendFd, F_SETFL, flags | O_NONBLOCK);
+// A hard recv/send/splice error; on the backend side (typically a reset) it also counts
+// against the backend.
+void Connection::onIoError(int fd) {
+    if (fd == m_BackendFd)
+        noteBackendFailure();
+    onClose(fd);
+}
 
-    return true;
+void Connection::attachEventLoop(IEventLoop* loop) {
+    m_Loop = loop;
+    m_ClientInterest = {true, false};
+    m_BackendInterest = {true, true};
 }
-void Connection::closeAll() {
-    if (m_ClientFd >= 0) {
-        close(m_ClientFd);
-        m_ClientFd = -1;
+
+void Connection::closeFd(int& fd) {
+    if (fd < 0)
+        return;
+    if (m_Loop)
+        m_Loop->unregisterFd(fd);
+    if (&fd == &m_BackendFd && m_Options.connectionPool)
+        m_Options.connectionPool->discard(m_Backend, fd);
+    close(fd);
+    fd = -1;
+}
+
+// Called from the read paths, right after onReadable refreshed m_LastActivity, so the
+// latency sample costs no extra clock read.
+void Connection::noteReceived(const Direction& dir) noexcept {
+    if (&dir == &m_Upstream) {
+        m_ClientSpoke = true;
+        m_BackendSpokeLast = false;
+        if (m_TurnStart == std::chrono::steady_clock::time_point{})
+            m_TurnStart = m_LastActivity;
+    } else {
+        m_BackendSpokeLast = true;
+        if (m_TurnStart != std::chrono::steady_clock::time_point{} && m_Backend.stats) {
+            m_Backend.stats->observeLatency(m_LastActivity - m_TurnStart, m_LastActivity);
+            m_TurnStart = {};
+        }
     }
-    if (m_BackendFd >= 0) {
-        close(m_BackendFd);
-        m_BackendFd = -1;
+}
+
+// A raw byte stream has no message framing to go by, so "clean" is the request/response
+// boundary as seen from here: the client sent something, the backend answered last, and
+// nothing is left in flight either way, queued here or unread in the backend socket.
+bool Connection::backendReusable() const {
+    if (!m_Options.reuseBackend || !m_Options.connectionPool || !m_Connected || m_BackendFd < 0)
+        return false;
+    if (!m_ClientSpoke || !m_BackendSpokeLast || bufferedToBackend() > 0 || bufferedToClient() > 0)
+        return false;
+    char byte;
+    ssize_t peeked = recv(m_BackendFd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+    return peeked < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+// Hands the still-open backend socket back to the pool (or, if the pool never lent or
+// adopted it, closes it after all).
+void Connection::releaseBackend() {
+    int fd = m_BackendFd;
+    m_BackendFd = -1;
+    if (m_Loop)
+        m_Loop->unregisterFd(fd);
+    if (m_Options.connectionPool->release(m_Backend, fd)) {
+        m_Logger.logDebug("Returned backend fd=" + std::to_string(fd) + " to the pool");
+    } else {
+        close(fd);
     }
+}
+
+void Connection::closeAll() {
+    closeFd(m_ClientFd);
+    closeFd(m_BackendFd);
+    closePipes();
+    releaseStorage(m_Upstream);
+    releaseStorage(m_Downstream);
+    if (m_Loop && m_MemoryRetryTimer != INVALID_TIMER_ID)
+        m_Loop->cancelTimer(m_MemoryRetryTimer);
+    m_MemoryRetryTimer = INVALID_TIMER_ID;
     m_Connected = false;
 }
 
+bool Connection::isReadPaused(int fd) const noexcept {
+    if (fd == m_ClientFd)
+        return m_Upstream.sourcePaused;
+    if (fd == m_BackendFd)
+        return m_Downstream.sourcePaused;
+    return false;
+}
+
 void Connection::onReadable(int fd) {
     refreshActivity();
     m_Logger.logInfo("Readable event on fd " + std::to_string(fd));
-    char buffer[8192];
-    ssize_t bytesRead = recv(fd, buffer, sizeof(buffer), 0);
-    if (bytesRead < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            return;
+    bool fromClient = fd == m_ClientFd;
+    if (!fromClient && fd != m_BackendFd)
+        return;
+
+    int targetFd = fromClient ? m_BackendFd : m_ClientFd;
+    Direction& dir = fromClient ? m_Upstream : m_Downstream;
+    if (dir.waitingForMemory && ensureStorage(dir)) {
+        dir.waitingForMemory = false;
+        dir.sourcePaused = false;
+    }
+    if (dir.sourcePaused)
+        return;
+    if (m_Options.useSplice && spliceForward(fd, targetFd, dir))
+        return;
+    copyForward(fd, targetFd, dir);
+}
+
+// Reads until EAGAIN, a short read, backpressure, or the per-wakeup budget. With
+// edge-triggered readiness anything left in the socket would otherwise stall until
+// the peer sends again, so running out of budget re-arms the fd instead.
+//
+// While nothing is queued the bytes pass through the thread's scratch buffer and the
+// direction holds no memory; it borrows a ring only for what a send leaves behind.
+void Connection::copyForward(int fd, int targetFd, Direction& dir) {
+    size_t moved = 0;
+    iovec spans[2];
+    while (!dir.sourcePaused) {
+        bool direct = dir.buffer.empty() && targetFd >= 0 && (targetFd != m_BackendFd || m_Connected);
+        int count = 1;
+        if (direct) {
+            if (memoryExhausted()) {
+                forwardUnbuffered(fd, targetFd, dir);
+                break;
+            }
+            spans[0].iov_base = scratchBuffer(dir.buffer.capacity());
+            spans[0].iov_len = dir.buffer.capacity();
         } else {
+            if (!ensureStorage(dir)) {
+                if (!forwardUnbuffered(fd, targetFd, dir))
+                    waitForMemory(fd, dir);
+                break;
+            }
+            count = dir.buffer.writableSpans(spans);
+            if (count == 0)
+                break;
+        }
+        size_t wanted = spans[0].iov_len + (count > 1 ? spans[1].iov_len : 0);
+
+        ssize_t bytesRead = readv(fd, spans, count);
+        if (bytesRead < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
             m_Logger.logError("Recv failed on fd=" + std::to_string(fd) + " (" + strerror(errno) + ")");
+            onIoError(fd);
+            return;
+        }
+        if (bytesRead == 0) {
+            m_Logger.logInfo("Peer closed connection on fd=" + std::to_string(fd) + ")");
             onClose(fd);
             return;
         }
-    }
 
-    if (bytesRead == 0) {
-        m_Logger.logInfo("Peer closed connection on fd=" + std::to_string(fd) + ")");
-        onClose(fd);
-        return;
+        moved += static_cast<size_t>(bytesRead);
+        noteReceived(dir);
+        bool open;
+        if (direct) {
+            open = sendDirect(targetFd, dir, static_cast<const char*>(spans[0].iov_base),
+                              static_cast<size_t>(bytesRead));
+        } else {
+            dir.buffer.commitWrite(static_cast<size_t>(bytesRead));
+            open = flush(targetFd, dir);
+        }
+        applyBackpressure(fd, dir);
+        if (!open || static_cast<size_t>(bytesRead) < wanted)
+            break;
+        if (moved >= m_Options.wakeupBudget) {
+            rearm(fd);
+            break;
+        }
     }
-    int targetFd = (fd == m_ClientFd) ? m_BackendFd : m_ClientFd;
 
-    m_Logger.logDebug("Read " + std::to_string(bytesRead) + " bytes from fd=" + std::to_string(fd) +
-                       ", forwarding to fd=" + std::to_string(targetFd));
+    if (moved > 0)
+        m_Logger.logDebug("Read " + std::to_string(moved) + " bytes from fd=" + std::to_string(fd) +
+                           ", forwarding to fd=" + std::to_string(targetFd));
+}
 
-    ssize_t sent = send(targetFd, buffer, bytesRead, 0);
+// Sends freshly read scratch bytes straight to the target. Only the part the target
+// does not take is copied into a borrowed ring. Returns false if the target is gone.
+bool Connection::sendDirect(int targetFd, Direction& dir, const char* data, size_t len) {
+    ssize_t sent;
+    while ((sent = send(targetFd, data, len, 0)) < 0 && errno == EINTR) {}
     if (sent < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            return;
-        } else {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
             m_Logger.logError("Send failed on fd=" + std::to_string(targetFd) + " (" + strerror(errno) + ")");
-            onClose(targetFd);
-            return;
+            onIoError(targetFd);
+            return false;
         }
+        sent = 0;
     }
-    else if (sent < bytesRead) {
-        m_PendingWrites[targetFd].append(buffer + sent, bytesRead - sent);
+    if (static_cast<size_t>(sent) < len) {
+        // The bytes are already out of the source socket, so there is no backing off
+        // here. copyForward checked the pool first; losing that race costs a heap block.
+        if (!ensureStorage(dir))
+            dir.buffer.attach(new char[dir.buffer.capacity()]);
+        dir.buffer.write(data + sent, len - static_cast<size_t>(sent));
     }
+    updateInterest(targetFd);
+    return true;
 }
 
 void Connection::onWritable(int fd) {
     refreshActivity();
-    auto it = m_PendingWrites.find(fd);
-    if (it == m_PendingWrites.end() || it->second.empty()) {
+    bool toBackend = fd == m_BackendFd;
+    if (!toBackend && fd != m_ClientFd)
         return;
+
+    Direction& dir = toBackend ? m_Upstream : m_Downstream;
+    dir.blockedOnTarget = false;
+    if (!flush(fd, dir))
+        return;
+    applyBackpressure(toBackend ? m_ClientFd : m_BackendFd, dir);
+}
+
+// Writes as much of the direction's backlog as the target takes. Returns false if the
+// target is gone.
+bool Connection::flush(int targetFd, Direction& dir) {
+    if (targetFd < 0) {
+        releaseStorage(dir);
+        return false;
     }
+    // Held until the non-blocking connect completes; the reactor flushes on connect.
+    if (targetFd == m_BackendFd && !m_Connected)
+        return true;
 
-    std::string& data = it->second;
-    ssize_t sent = send(fd, data.data(), data.size(), 0);
-    if (sent < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            return;
-        } else {
-            m_Logger.logError("Send failed on fd=" + std::to_string(fd) + " (" + strerror(errno) + ")");
-            onClose(fd);
-            return;
+    if (dir.pipe.pending > 0 && !flushPipe(dir.pipe, targetFd))
+        return false;
+
+    iovec spans[2];
+    while (int count = dir.buffer.readableSpans(spans)) {
+        ssize_t sent = writev(targetFd, spans, count);
+        if (sent < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            m_Logger.logError("Send failed on fd=" + std::to_string(targetFd) + " (" + strerror(errno) + ")");
+            onIoError(targetFd);
+            return false;
         }
+        dir.buffer.consume(static_cast<size_t>(sent));
+        // A short write means the socket buffer is full; the next writev would only EAGAIN.
+        if (static_cast<size_t>(sent) < spans[0].iov_len + (count > 1 ? spans[1].iov_len : 0))
+            break;
+    }
+
+    // Drained: give the ring back so a quiet connection holds no buffer memory.
+    if (dir.buffer.empty())
+        releaseStorage(dir);
+    updateInterest(targetFd);
+    return true;
+}
+
+void Connection::applyBackpressure(int sourceFd, Direction& dir) {
+    size_t pending = dir.buffer.size();
+    bool pipeBacklog = dir.pipe.pending > 0;
+    if (!dir.sourcePaused && (pending >= dir.highWatermark || pipeBacklog)) {
+        dir.sourcePaused = true;
+        m_Logger.logDebug("Pausing reads on fd=" + std::to_string(sourceFd) + " (" +
+                          std::to_string(pending) + " bytes buffered)");
+    } else if (dir.sourcePaused && !dir.waitingForMemory && pending <= dir.lowWatermark && !pipeBacklog) {
+        dir.sourcePaused = false;
+        m_Logger.logDebug("Resuming reads on fd=" + std::to_string(sourceFd));
+    }
+    updateInterest(sourceFd);
+}
+
+// Reads are on unless the fd's outbound peer is backed up; writes are on only while
+// something is queued for the fd (or its connect is still pending). Only changes
+// reach the event loop.
+void Connection::updateInterest(int fd) {
+    if (!m_Loop || fd < 0)
+        return;
+
+    bool isBackend = fd == m_BackendFd;
+    const Direction& inbound = isBackend ? m_Downstream : m_Upstream;
+    const Direction& outbound = isBackend ? m_Upstream : m_Downstream;
+    Interest want{!inbound.sourcePaused,
+                  !outbound.buffer.empty() || outbound.pipe.pending > 0 || outbound.blockedOnTarget ||
+                      (isBackend && !m_Connected)};
+
+    Interest& current = isBackend ? m_BackendInterest : m_ClientInterest;
+    if (want.read == current.read && want.write == current.write)
+        return;
+    current = want;
+    m_Loop->updateFd(fd, want.read, want.write);
+}
+
+// Re-submits the current interest so the loop reports the fd again if it is still
+// ready (a fresh edge for epoll, a new poll for io_uring).
+void Connection::rearm(int fd) {
+    if (!m_Loop || fd < 0)
+        return;
+    const Interest& current = fd == m_BackendFd ? m_BackendInterest : m_ClientInterest;
+    m_Loop->updateFd(fd, current.read, current.write);
+}
+
+bool Connection::ensureStorage(Direction& dir) {
+    if (dir.buffer.hasStorage())
+        return true;
+    char* chunk = m_Options.bufferPool ? m_Options.bufferPool->acquire() : new char[dir.buffer.capacity()];
+    if (!chunk)
+        return false;
+    dir.buffer.attach(chunk);
+    return true;
+}
+
+void Connection::releaseStorage(Direction& dir) {
+    char* chunk = dir.buffer.detach();
+    if (!chunk)
+        return;
+    if (m_Options.bufferPool && m_Options.bufferPool->owns(chunk))
+        m_Options.bufferPool->release(chunk);
+    else
+        delete[] chunk;
+}
+
+bool Connection::memoryExhausted() const noexcept {
+    return m_Options.bufferPool && m_Options.bufferPool->available() == 0;
+}
+
+size_t Connection::stateBytes() const noexcept {
+    size_t bytes = sizeof(*this);
+    for (const Direction* dir : {&m_Upstream, &m_Downstream}) {
+        if (dir->buffer.hasStorage())
+            bytes += dir->buffer.capacity();
     }
+    return bytes;
+}
+
+// Pool exhausted: forward without holding any memory. Peek into the thread's scratch
+// buffer, send what the target takes right now, then consume exactly that much from
+// the source. Slower, but connections keep moving instead of waiting on each other's
+// chunks. Returns false when this is not possible (target not writable yet or
+// data already queued), leaving the caller to wait for memory.
+bool Connection::forwardUnbuffered(int fd, int targetFd, Direction& dir) {
+    if (targetFd < 0 || (targetFd == m_BackendFd && !m_Connected) || !dir.buffer.empty())
+        return false;
+
+    char* scratch = scratchBuffer(dir.buffer.capacity());
+    size_t moved = 0;
+    while (moved < m_Options.wakeupBudget) {
+        ssize_t peeked = recv(fd, scratch, dir.buffer.capacity(), MSG_PEEK);
+        if (peeked < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
+            m_Logger.logError("Recv failed on fd=" + std::to_string(fd) + " (" + strerror(errno) + ")");
+            onIoError(fd);
+            return true;
+        }
+        if (peeked == 0) {
+            m_Logger.logInfo("Peer closed connection on fd=" + std::to_string(fd) + ")");
+            onClose(fd);
+            return true;
+        }
 
-    data.erase(0, sent);
-    if (data.empty()) {
-        m_PendingWrites.erase(it);
+        ssize_t sent = send(targetFd, scratch, static_cast<size_t>(peeked), 0);
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            m_Logger.logError("Send failed on fd=" + std::to_string(targetFd) + " (" + strerror(errno) + ")");
+            onIoError(targetFd);
+            return true;
+        }
+        if (sent > 0) {
+            // Drop exactly what was delivered; it is already queued in the socket.
+            while (recv(fd, scratch, static_cast<size_t>(sent), 0) < 0 && errno == EINTR) {}
+            moved += static_cast<size_t>(sent);
+            noteReceived(dir);
+        }
+        if (sent < peeked) {
+            // Target is full: park the source until the target reports writable.
+            dir.blockedOnTarget = true;
+            dir.sourcePaused = true;
+            updateInterest(targetFd);
+            updateInterest(fd);
+            return true;
+        }
     }
+    rearm(fd);
+    return true;
 }
 
+// The pool's budget is spent: stop reading this side (the socket buffer and TCP flow
+// control hold the data meanwhile) and try again shortly, rather than allocating.
+void Connection::waitForMemory(int fd, Direction& dir) {
+    if (!dir.waitingForMemory)
+        m_Logger.logDebug("Buffer pool exhausted; pausing reads on fd=" + std::to_string(fd));
+    dir.waitingForMemory = true;
+    dir.sourcePaused = true;
+    updateInterest(fd);
+    scheduleMemoryRetry();
+}
+
+void Connection::scheduleMemoryRetry() {
+    if (!m_Loop || m_MemoryRetryTimer != INVALID_TIMER_ID)
+        return;
+    m_MemoryRetryTimer = m_Loop->addTimer(MEMORY_RETRY_DELAY, [this]() {
+        m_MemoryRetryTimer = INVALID_TIMER_ID;
+        retryMemory();
+    });
+}
+
+void Connection::retryMemory() {
+    bool stillWaiting = false;
+    for (auto [dir, sourceFd] : {std::pair<Direction*, int>{&m_Upstream, m_ClientFd},
+                                 std::pair<Direction*, int>{&m_Downstream, m_BackendFd}}) {
+        if (!dir->waitingForMemory)
+            continue;
+        if (sourceFd >= 0 && !ensureStorage(*dir)) {
+            stillWaiting = true;
+            continue;
+        }
+        dir->waitingForMemory = false;
+        dir->sourcePaused = false;
+        updateInterest(sourceFd);
+    }
+    if (stillWaiting)
+        scheduleMemoryRetry();
+}
 
 void Connection::onClose(int fd) {
     m_Logger.logInfo("Close event on fd " + std::to_string(fd));
 
+    // Whatever was still queued for the closed side has nowhere to go. Without the
+    // client the backend connection has no one to answer either: it goes back to the
+    // pool if it is at a clean boundary, and is closed otherwise (holding it would keep
+    // the backend's slot, see ConnectionPool::admit, taken).
     if (fd == m_ClientFd) {
         m_Logger.logDebug("Client socket closed");
-        close(m_ClientFd);
-        m_ClientFd = -1;
+        bool reusable = backendReusable();
+        closeFd(m_ClientFd);
+        releaseStorage(m_Downstream);
+        if (reusable)
+            releaseBackend();
+        else
+            closeFd(m_BackendFd);
+        releaseStorage(m_Upstream);
     } else if (fd == m_BackendFd) {
         m_Logger.logDebug("Backend socket closed");
-        close(m_BackendFd);
-        m_BackendFd = -1;
+        closeFd(m_BackendFd);
+        releaseStorage(m_Upstream);
     }
 
     if (m_ClientFd < 0 && m_BackendFd < 0) {
         m_Logger.logDebug("Both ends closed; cleaning up connection");
+        closePipes();
         m_Connected = false;
     }
 }
 
+// Moves one chunk fd -> pipe -> targetFd without copying through user space. Returns
+// false when splice cannot be used for this connection, in which case the caller
+// takes the copy path (and keeps using it from then on).
+bool Connection::spliceForward(int fd, int targetFd, Direction& dir) {
+#ifdef __linux__
+    SplicePipe& pipe = dir.pipe;
+    if (pipe.readFd < 0) {
+        int fds[2];
+        if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+            m_Logger.logError(std::string("pipe2 failed, falling back to copy forwarding (") + strerror(errno) + ")");
+            m_Options.useSplice = false;
+            return false;
+        }
+        pipe.readFd = fds[0];
+        pipe.writeFd = fds[1];
+    }
+
+    // Bytes left over from a short write go out first; do not pull more in while the
+    // target cannot take them.
+    if (pipe.pending > 0) {
+        if (flush(targetFd, dir))
+            applyBackpressure(fd, dir);
+        if (pipe.pending > 0)
+            return true;
+    }
+
+    size_t total = 0;
+    while (!dir.sourcePaused) {
+        ssize_t moved = splice(fd, nullptr, pipe.writeFd, nullptr, SPLICE_CHUNK, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (moved < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            if (errno == EINVAL && total == 0) {
+                m_Logger.logInfo("splice not supported on fd=" + std::to_string(fd) + ", using copy forwarding");
+                closePipes();
+                m_Options.useSplice = false;
+                return false;
+            }
+            m_Logger.logError("Splice failed on fd=" + std::to_string(fd) + " (" + strerror(errno) + ")");
+            onIoError(fd);
+            return true;
+        }
+        if (moved == 0) {
+            m_Logger.logInfo("Peer closed connection on fd=" + std::to_string(fd) + ")");
+            onClose(fd);
+            return true;
+        }
+
+        pipe.pending += static_cast<size_t>(moved);
+        total += static_cast<size_t>(moved);
+        noteReceived(dir);
+        bool open = flush(targetFd, dir);
+        applyBackpressure(fd, dir);
+        if (!open)
+            break;
+        if (total >= m_Options.wakeupBudget) {
+            rearm(fd);
+            break;
+        }
+    }
+    return true;
+#else
+    (void)fd;
+    (void)targetFd;
+    (void)dir;
+    return false;
+#endif
+}
+
+bool Connection::flushPipe(SplicePipe& pipe, int targetFd) {
+#ifdef __linux__
+    while (pipe.pending > 0) {
+        ssize_t sent = splice(pipe.readFd, nullptr, targetFd, nullptr, pipe.pending,
+                              SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
+            m_Logger.logError("Splice failed on fd=" + std::to_string(targetFd) + " (" + strerror(errno) + ")");
+            onIoError(targetFd);
+            return false;
+        }
+        pipe.pending -= static_cast<size_t>(sent);
+    }
+#else
+    (void)pipe;
+    (void)targetFd;
+#endif
+    return true;
+}
+
+void Connection::closePipes() {
+    for (SplicePipe* pipe : {&m_Upstream.pipe, &m_Downstream.pipe}) {
+        if (pipe->readFd >= 0)
+            close(pipe->readFd);
+        if (pipe->writeFd >= 0)
+            close(pipe->writeFd);
+        *pipe = SplicePipe{};
+    }
+}
 
 void Connection::refreshActivity() {
     m_LastActivity = std::chrono::steady_clock::now();
@@ -1,113 +1,510 @@
 #include "connection_pool.h"
 #include <sys/socket.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <arpa/inet.h>
 #include <unistd.h>
-#include "network_utils.h"
+#include <algorithm>
+#include <cerrno>
+#include <sys/resource.h>
+#include <thread>
+#include <utility>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
 
-int ConnectionPool::acquire(const BackendConfig& backend) {
-    {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-        auto& conns = m_Pool[backend.host + ":" + std::to_string(backend.port)];
-        for (auto& conn : conns) {
-            if (!conn.inUse) {
-                conn.inUse = true;
-                conn.lastUsed = std::chrono::steady_clock::now();
-                return conn.fd;
-            }
+static constexpr size_t UNBOUND_SHARD = SIZE_MAX;
+static thread_local size_t t_ShardIndex = UNBOUND_SHARD;
+static std::atomic<size_t> g_NextUnboundThread{0};
+
+// Every fd the process may open, including any soft-limit raise up to the hard limit.
+static size_t maxOpenFds() {
+    constexpr size_t FD_CEILING = size_t{1} << 31;   // fds are ints
+    rlimit limit{};
+    if (::getrlimit(RLIMIT_NOFILE, &limit) != 0)
+        return size_t{1} << 20;
+    rlim_t most = std::max(limit.rlim_cur, limit.rlim_max);
+    if (most == RLIM_INFINITY || most > FD_CEILING)
+        return FD_CEILING;
+    return static_cast<size_t>(most);
+}
+
+ConnectionPool::ConnectionPool(const ConnectionPoolConfig& config, size_t maxBackends, size_t shardCount)
+    : m_MaxConnectionsPerBackend(config.maxConnectionsPerBackend),
+      m_IdleTtl(config.idleTtlMs),
+      m_MaxActive(config.maxActivePerBackend),
+      m_WaitQueueDepth(config.waitQueueDepth),
+      m_WaitTimeout(config.waitTimeoutMs),
+      m_Backends(std::make_unique<BackendState[]>(maxBackends)),
+      m_MaxBackends(maxBackends)
+{
+    m_SegmentCount = (maxOpenFds() + (size_t{1} << SEGMENT_BITS) - 1) >> SEGMENT_BITS;
+    m_Owners = std::make_unique<std::atomic<Segment*>[]>(m_SegmentCount);
+    if (shardCount == 0)
+        shardCount = std::max(1u, std::thread::hardware_concurrency());
+    m_Shards.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        m_Shards.push_back(std::make_unique<Shard>());
+        m_Shards.back()->idle.resize(maxBackends);
+        m_Shards.back()->demand.resize(maxBackends);
+    }
+    if (m_MaxActive > 0)
+        m_Queues = std::make_unique<WaitQueue[]>(maxBackends);
+#ifdef __linux__
+    m_WatchFd = ::epoll_create1(EPOLL_CLOEXEC);
+#endif
+}
+
+ConnectionPool::~ConnectionPool() {
+    m_Queues.reset();   // waiters' callbacks may still hold client connections
+    for (auto& shard : m_Shards) {
+        for (auto& idle : shard->idle) {
+            for (const auto& conn : idle)
+                ::close(conn.fd);
         }
     }
+    for (size_t i = 0; i < m_SegmentCount; ++i)
+        delete m_Owners[i].load(std::memory_order_relaxed);
+    if (m_WatchFd >= 0)
+        ::close(m_WatchFd);
+}
 
-    return addNewConnection(backend);
+void ConnectionPool::bindThreadToShard(size_t index) noexcept {
+    t_ShardIndex = index;
 }
 
-void ConnectionPool::release(const BackendConfig& backend, int fd) {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-    auto& conns = m_Pool[backend.host + ":" + std::to_string(backend.port)];
+size_t ConnectionPool::homeShard() const noexcept {
+    if (t_ShardIndex == UNBOUND_SHARD)
+        t_ShardIndex = g_NextUnboundThread.fetch_add(1, std::memory_order_relaxed);
+    return t_ShardIndex % m_Shards.size();
+}
 
-    for (auto& conn : conns) {
-        if (conn.fd == fd) {
-            conn.inUse = false;
-            return;
-        }
+std::atomic<uint32_t>* ConnectionPool::ownerSlot(int fd, bool create) {
+    if (fd < 0)
+        return nullptr;
+    size_t segment = static_cast<size_t>(fd) >> SEGMENT_BITS;
+    if (segment >= m_SegmentCount)
+        return nullptr;
+
+    Segment* table = m_Owners[segment].load(std::memory_order_acquire);
+    if (!table) {
+        if (!create)
+            return nullptr;
+        auto fresh = std::make_unique<Segment>();
+        for (auto& word : *fresh)
+            word.store(0, std::memory_order_relaxed);
+        if (m_Owners[segment].compare_exchange_strong(table, fresh.get(), std::memory_order_acq_rel))
+            table = fresh.release();
     }
+    return &(*table)[static_cast<size_t>(fd) & ((size_t{1} << SEGMENT_BITS) - 1)];
 }
 
-void ConnectionPool::cleanupIdleConnections() {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-    auto now = std::chrono::steady_clock::now();
+int ConnectionPool::acquire(const Backend& backend) {
+    if (backend.id >= m_MaxBackends)
+        return -1;
+
+    size_t start = homeShard();
+    for (size_t i = 0; i < m_Shards.size(); ++i) {
+        Shard& shard = *m_Shards[(start + i) % m_Shards.size()];
+        std::unique_lock<std::mutex> lock(shard.mutex, std::defer_lock);
+        if (i == 0) {
+            lock.lock();
+            ++shard.demand[backend.id];
+        } else if (!lock.try_lock()) {
+            continue;   // busy: someone else is on it, try the next one
+        }
 
-    for (auto it = m_Pool.begin(); it != m_Pool.end();) {
-        auto& conns = it->second;
-        conns.erase(std::remove_if(conns.begin(), conns.end(),
-            [&](const PooledBackendConn& conn) {
-                return !conn.inUse && (now - conn.lastUsed > std::chrono::minutes(5));
-            }), conns.end());
+        auto& idle = shard.idle[backend.id];
+        if (idle.empty())
+            continue;
+        int fd = idle.back().fd;
+        idle.pop_back();
+        ownerSlot(fd, false)->store(ownerWord(backend.id, LENT), std::memory_order_relaxed);
+        return fd;
+    }
+    return -1;
+}
 
-        if (conns.empty()) {
-            it = m_Pool.erase(it);
+ConnectionPool::Admission ConnectionPool::admit(const Backend& backend, int& fd) {
+    fd = -1;
+    if (backend.id >= m_MaxBackends)
+        return Admission::Granted;
+    if (m_Queues) {
+        WaitQueue& queue = m_Queues[backend.id];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        // No overtaking: a freed slot belongs to the oldest waiter.
+        if (!queue.waiters.empty() || queue.active >= m_MaxActive)
+            return Admission::Full;
+        ++queue.active;
+    }
+    fd = acquire(backend);
+    return Admission::Granted;
+}
+
+ConnectionPool::Admission ConnectionPool::wait(const Backend& backend, GrantCallback onGrant, int& fd,
+                                               WaitTicket& ticket) {
+    fd = -1;
+    if (!m_Queues || backend.id >= m_MaxBackends)
+        return Admission::Rejected;
+    WaitQueue& queue = m_Queues[backend.id];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.waiters.empty() && queue.active < m_MaxActive) {
+            ++queue.active;
         } else {
-            ++it;
+            if (queue.waiters.size() >= m_WaitQueueDepth)
+                return Admission::Rejected;
+            ticket = m_NextTicket.fetch_add(1, std::memory_order_relaxed);
+            queue.waiters.push_back({ticket, std::move(onGrant)});
+            return Admission::Queued;
         }
     }
+    fd = acquire(backend);
+    return Admission::Granted;
 }
 
-int ConnectionPool::addNewConnection(const BackendConfig& backend) {
-    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
-    if (fd < 0) return -1;
+bool ConnectionPool::cancelWait(const Backend& backend, WaitTicket ticket) {
+    if (!m_Queues || backend.id >= m_MaxBackends)
+        return false;
+    WaitQueue& queue = m_Queues[backend.id];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    auto it = std::find_if(queue.waiters.begin(), queue.waiters.end(),
+                           [ticket](const Waiter& waiter) { return waiter.ticket == ticket; });
+    if (it == queue.waiters.end())
+        return false;
+    queue.waiters.erase(it);
+    return true;
+}
 
-    sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(backend.port);
-    inet_pton(AF_INET, backend.host.c_str(), &addr.sin_addr);
+void ConnectionPool::releaseSlot(const Backend& backend) {
+    if (backend.id < m_MaxBackends)
+        handOff(backend.id, -1);
+}
 
-    if (::connectWithTimeout(fd, addr, CONNECT_TIMEOUT_MS) < 0) {
-        ::close(fd);
-        return -1;
+void ConnectionPool::adopt(const Backend& backend, int fd) {
+    std::atomic<uint32_t>* slot = ownerSlot(fd, true);
+    if (slot && backend.id < m_MaxBackends)
+        slot->store(ownerWord(backend.id, LENT | ADOPTED), std::memory_order_relaxed);
+}
+
+// Passes a freed slot (and `fd`, when it is a live connection) to the oldest waiter.
+// Without one the slot just frees up; returns whether a waiter took it.
+bool ConnectionPool::handOff(BackendId id, int fd) {
+    if (!m_Queues)
+        return false;
+    WaitQueue& queue = m_Queues[id];
+    Waiter next;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.waiters.empty()) {
+            if (queue.active > 0)
+                --queue.active;
+            return false;
+        }
+        next = std::move(queue.waiters.front());
+        queue.waiters.pop_front();
     }
+    next.grant(fd);
+    return true;
+}
 
-    std::lock_guard<std::mutex> lock(m_Mutex);
-    std::string key = backend.host + ":" + std::to_string(backend.port);
+bool ConnectionPool::reserveOpen(BackendId id) {
+    BackendState& state = m_Backends[id];
+    size_t open = state.open.load(std::memory_order_relaxed);
+    do {
+        if (open >= m_MaxConnectionsPerBackend)
+            return false;
+    } while (!state.open.compare_exchange_weak(open, open + 1, std::memory_order_relaxed));
+    return true;
+}
+
+bool ConnectionPool::release(const Backend& backend, int fd) {
+    if (backend.id >= m_MaxBackends)
+        return false;
+    std::atomic<uint32_t>* slot = ownerSlot(fd, false);
+    if (!slot) {
+        // Beyond the owner table (the hard fd limit was raised after construction), so
+        // adopt() could not track it: the caller closes it, but the slot must still free.
+        if (fd >= 0)
+            handOff(backend.id, -1);
+        return false;
+    }
+    // Only the borrower releases a lent fd, so nothing else changes the word under us.
+    uint32_t word = slot->load(std::memory_order_relaxed);
+    if (word == 0 || ownerId(word) != backend.id || !(word & LENT))
+        return false;
+    if (handOff(backend.id, fd))
+        return true;   // still lent, now to the next client in line
 
-    if (m_Pool[key].size() < m_MaxConnectionsPerBackend) {
-        removeOldestIdleConnections();
-        m_Pool[key].push_back({fd, false, std::chrono::steady_clock::now()});
-    } else {
+    // A connection the client dialed itself joins the pool if there is room for it.
+    if ((word & ADOPTED) && !reserveOpen(backend.id)) {
+        slot->store(0, std::memory_order_relaxed);
         ::close(fd);
-        return -1;
+        return true;
     }
+    slot->store(ownerWord(backend.id, 0), std::memory_order_relaxed);
+    watch(fd);
+    Shard& shard = *m_Shards[homeShard()];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.idle[backend.id].push_back({fd, std::chrono::steady_clock::now()});
+    return true;
+}
 
-    return fd;
+void ConnectionPool::discard(const Backend& backend, int fd) {
+    if (backend.id >= m_MaxBackends)
+        return;
+    std::atomic<uint32_t>* slot = ownerSlot(fd, false);
+    if (!slot) {
+        if (fd >= 0)
+            handOff(backend.id, -1);   // untracked, as in release()
+        return;
+    }
+    uint32_t word = slot->load(std::memory_order_relaxed);
+    if (word == 0 || ownerId(word) != backend.id || !(word & LENT))
+        return;
+    slot->store(0, std::memory_order_relaxed);
+    if (!(word & ADOPTED))
+        m_Backends[backend.id].open.fetch_sub(1, std::memory_order_relaxed);
+    handOff(backend.id, -1);
 }
 
-void ConnectionPool::removeOldestIdleConnections() {
-    for (auto& [key, conns] : m_Pool) {
-        if (conns.size() <= m_MaxConnectionsPerBackend) continue;
+size_t ConnectionPool::cleanupIdleConnections() {
+    auto now = std::chrono::steady_clock::now();
+    size_t closed = 0;
+    for (auto& shard : m_Shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (BackendId id = 0; id < m_MaxBackends; ++id) {
+            auto& idle = shard->idle[id];
+            // Stacks are pushed in time order, so the stale ones are a prefix.
+            auto fresh = std::find_if(idle.begin(), idle.end(),
+                [&](const PooledBackendConn& conn) { return now - conn.lastUsed <= m_IdleTtl; });
+            for (auto it = idle.begin(); it != fresh; ++it)
+                forget(it->fd, id);
+            closed += static_cast<size_t>(fresh - idle.begin());
+            idle.erase(idle.begin(), fresh);
+        }
+    }
+    return closed;
+}
 
-        std::sort(conns.begin(), conns.end(),
-            [](const PooledBackendConn& a, const PooledBackendConn& b) {
-                return a.lastUsed < b.lastUsed;
-            });
+size_t ConnectionPool::reapClosed() {
+#ifdef __linux__
+    if (m_WatchFd < 0)
+        return 0;
+    size_t closed = 0;
+    epoll_event events[64];
+    int n;
+    do {
+        n = ::epoll_wait(m_WatchFd, events, 64, 0);
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            std::atomic<uint32_t>* slot = ownerSlot(fd, false);
+            uint32_t word = slot ? slot->load(std::memory_order_relaxed) : 0;
+            // Lent fds fire on their first response; the one-shot is spent, nothing to do.
+            if (word == 0 || (word & LENT))
+                continue;
+            if (evictIdle(fd, ownerId(word)))
+                ++closed;
+        }
+    } while (n == 64);
+    return closed;
+#else
+    return 0;
+#endif
+}
 
-        while (conns.size() > m_MaxConnectionsPerBackend) {
-            auto it = std::find_if(conns.begin(), conns.end(),
-                [](const PooledBackendConn& conn) { return !conn.inUse; });
-            if (it != conns.end()) {
-                ::close(it->fd);
-                conns.erase(it);
+// One-shot so a fd that fires, or is later lent and used, stays quiet until re-armed.
+void ConnectionPool::watch(int fd) {
+#ifdef __linux__
+    if (m_WatchFd < 0)
+        return;
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    ev.data.fd = fd;
+    if (::epoll_ctl(m_WatchFd, EPOLL_CTL_MOD, fd, &ev) < 0 && errno == ENOENT)
+        ::epoll_ctl(m_WatchFd, EPOLL_CTL_ADD, fd, &ev);
+#else
+    (void)fd;
+#endif
+}
+
+bool ConnectionPool::evictIdle(int fd, BackendId id) {
+    for (auto& shard : m_Shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        auto& idle = shard->idle[id];
+        auto it = std::find_if(idle.begin(), idle.end(),
+                               [fd](const PooledBackendConn& conn) { return conn.fd == fd; });
+        if (it != idle.end()) {
+            idle.erase(it);
+            forget(fd, id);
+            return true;
+        }
+    }
+    return false;   // lent out since the event fired
+}
+
+int ConnectionPool::addNewConnection(const Backend& backend) {
+    DialRequest request{&backend, 1};
+    return dialAll(&request, 1);
+}
+
+void ConnectionPool::addNewConnections(std::vector<DialRequest>& requests) {
+    dialAll(requests.data(), requests.size());
+}
+
+// Starts every connect before waiting on any, then polls them together against one
+// deadline. Returns the last fd pooled, or -1.
+int ConnectionPool::dialAll(DialRequest* requests, size_t count) {
+    std::vector<pollfd> pending;
+    std::vector<DialRequest*> owners;   // parallel to `pending`
+    int last = -1;
+    for (size_t r = 0; r < count; ++r) {
+        DialRequest& request = requests[r];
+        request.dialed = 0;
+        for (size_t i = 0; i < request.wanted; ++i) {
+            bool connected = false;
+            int fd = startDial(*request.backend, connected);
+            if (fd < 0)
+                break;   // unresolved, at its cap, or refused outright
+            if (connected) {
+                poolDialed(request.backend->id, fd);
+                ++request.dialed;
+                last = fd;
             } else {
-                break;
+                pending.push_back({fd, POLLOUT, 0});
+                owners.push_back(&request);
             }
         }
     }
-}
-bool ConnectionPool::isConnectionInPool(const BackendConfig& backend, int fd) {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-    auto& conns = m_Pool[backend.host + ":" + std::to_string(backend.port)];
 
-    for (const auto& conn : conns) {
-        if (conn.fd == fd) {
-            return true;
+    auto deadline = std::chrono::steady_clock::now() + CONNECT_TIMEOUT;
+    size_t inFlight = pending.size();
+    while (inFlight > 0) {
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0)
+            break;
+        int ready = ::poll(pending.data(), pending.size(), static_cast<int>(left.count()));
+        if (ready < 0 && errno == EINTR)
+            continue;
+        if (ready <= 0)
+            break;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            if (pending[i].fd < 0 || pending[i].revents == 0)
+                continue;
+            int fd = pending[i].fd;
+            BackendId id = owners[i]->backend->id;
+            int error = 0;
+            socklen_t len = sizeof(error);
+            if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
+                abandonDial(id, fd);
+            } else {
+                poolDialed(id, fd);
+                ++owners[i]->dialed;
+                last = fd;
+            }
+            pending[i].fd = -1;   // poll() skips negative fds
+            --inFlight;
         }
     }
-    return false;
-}
\ No newline at end of file
+    for (size_t i = 0; i < pending.size(); ++i) {
+        if (pending[i].fd >= 0)
+            abandonDial(owners[i]->backend->id, pending[i].fd);   // timed out
+    }
+    return last;
+}
+
+// Reserves a slot under the per-backend cap before connecting, so a full backend
+// costs no handshake.
+int ConnectionPool::startDial(const Backend& backend, bool& connected) {
+    if (backend.id >= m_MaxBackends || !backend.isResolved())
+        return -1;
+    if (!reserveOpen(backend.id))
+        return -1;
+
+    int fd = ::socket(backend.addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0 || !ownerSlot(fd, true)) {
+        abandonDial(backend.id, fd);
+        return -1;
+    }
+    int result = ::connect(fd, reinterpret_cast<const sockaddr*>(&backend.addr), backend.addrLen);
+    // EINTR leaves a non-blocking connect running, like EINPROGRESS.
+    if (result < 0 && errno != EINPROGRESS && errno != EINTR) {
+        abandonDial(backend.id, fd);
+        return -1;
+    }
+    connected = result == 0;
+    return fd;
+}
+
+void ConnectionPool::abandonDial(BackendId id, int fd) {
+    if (fd >= 0)
+        ::close(fd);
+    m_Backends[id].open.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ConnectionPool::poolDialed(BackendId id, int fd) {
+    // Pooled fds are handed out blocking; borrowers set their own mode.
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+    // Spread warm connections over the shards so no reactor has to steal them all.
+    ownerSlot(fd, false)->store(ownerWord(id, 0), std::memory_order_relaxed);
+    watch(fd);
+    Shard& shard = *m_Shards[m_NextDialShard.fetch_add(1, std::memory_order_relaxed) % m_Shards.size()];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.idle[id].push_back({fd, std::chrono::steady_clock::now()});
+}
+
+// Caller holds the lock of the shard the idle fd was taken from.
+void ConnectionPool::forget(int fd, BackendId id) {
+    ownerSlot(fd, false)->store(0, std::memory_order_relaxed);
+    ::close(fd);
+    m_Backends[id].open.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool ConnectionPool::isConnectionInPool(const Backend& backend, int fd) {
+    std::atomic<uint32_t>* slot = ownerSlot(fd, false);
+    if (!slot)
+        return false;
+    uint32_t word = slot->load(std::memory_order_relaxed);
+    return word != 0 && ownerId(word) == backend.id;
+}
+
+size_t ConnectionPool::idleCount(const Backend& backend) {
+    if (backend.id >= m_MaxBackends)
+        return 0;
+    size_t count = 0;
+    for (auto& shard : m_Shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        count += shard->idle[backend.id].size();
+    }
+    return count;
+}
+
+size_t ConnectionPool::takeDemand(const Backend& backend) {
+    if (backend.id >= m_MaxBackends)
+        return 0;
+    size_t demand = 0;
+    for (auto& shard : m_Shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        demand += std::exchange(shard->demand[backend.id], 0);
+    }
+    return demand;
+}
+
+void ConnectionPool::trimIdle(const Backend& backend, size_t keep) {
+    size_t idle = idleCount(backend);
+    if (idle <= keep)
+        return;
+    size_t excess = idle - keep;
+    for (auto& shard : m_Shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        auto& stack = shard->idle[backend.id];
+        // Oldest at the bottom of each stack.
+        size_t take = std::min(excess, stack.size());
+        for (size_t i = 0; i < take; ++i)
+            forget(stack[i].fd, backend.id);
+        stack.erase(stack.begin(), stack.begin() + static_cast<std::ptrdiff_t>(take));
+        excess -= take;
+        if (excess == 0)
+            break;
+    }
+}
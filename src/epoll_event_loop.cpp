@@ -1,8 +1,9 @@
-#include "event_loop.h"
+#include "event_loop_factory.h"
 #include <sys/epoll.h>
 #include <unistd.h>
 #include <cstring>
 #include <iostream>
+#include <stdexcept>
 
 class EpollEventLoop : public IEventLoop {
 public:
@@ -13,16 +14,13 @@ public:
     }
 
     ~EpollEventLoop() override {
-        ::close(m_EpollFd);
+        closeLoop();
     }
 
     bool registerFd(int fd, bool read, bool write) override {
         epoll_event ev{};
         ev.data.fd = fd;
-        ev.events = 0;
-        if (read) ev.events |= EPOLLIN;
-        if (write) ev.events |= EPOLLOUT;
-        ev.events |= EPOLLET; 
+        ev.events = interestMask(read, write);
         return epoll_ctl(m_EpollFd, EPOLL_CTL_ADD, fd, &ev) == 0;
     }
 
@@ -31,37 +29,68 @@ public:
     }
 
     int wait(std::vector<Event>& events, int timeoutMs) override {
-        constexpr int MAX_EVENTS = 256;
-        epoll_event evs[MAX_EVENTS];
-        int n = epoll_wait(m_EpollFd, evs, MAX_EVENTS, timeoutMs);
-        if (n < 0) return -1;
+        int n = epoll_wait(m_EpollFd, m_Ready, MAX_EVENTS, m_Timers.nextTimeoutMs(timeoutMs));
+        if (n < 0) {
+            events.clear();
+            return -1;
+        }
 
-        events.clear();
+        // data.fd is the reactor's slot index; fill the caller's reused buffer in place.
+        events.resize(n);
         for (int i = 0; i < n; ++i) {
-            Event e;
-            e.fd = evs[i].data.fd;
-            e.readable = evs[i].events & EPOLLIN;
-            e.writable = evs[i].events & EPOLLOUT;
-            e.error = evs[i].events & EPOLLERR;
-            e.closed = evs[i].events & EPOLLHUP;
-            events.push_back(e);
+            const uint32_t mask = m_Ready[i].events;
+            Event& e = events[i];
+            e.fd = m_Ready[i].data.fd;
+            e.readable = mask & EPOLLIN;
+            e.writable = mask & EPOLLOUT;
+            e.error = mask & EPOLLERR;
+            e.closed = mask & EPOLLHUP;
         }
         return n;
     }
 
-    void EpollEventLoop::updateFd(int fd, bool wantRead, bool wantWrite) {
+    void updateFd(int fd, bool wantRead, bool wantWrite) override {
         struct epoll_event ev{};
         ev.data.fd = fd;
-        ev.events = 0;
-        if (wantRead)  ev.events |= EPOLLIN;
-        if (wantWrite) ev.events |= EPOLLOUT;
+        ev.events = interestMask(wantRead, wantWrite);
         epoll_ctl(m_EpollFd, EPOLL_CTL_MOD, fd, &ev);
     }
     
     void closeLoop() override {
-        ::close(m_EpollFd);
+        if (m_EpollFd >= 0) {
+            ::close(m_EpollFd);
+            m_EpollFd = -1;
+        }
+    }
+
+    TimerId addTimer(std::chrono::milliseconds delay, TimerCallback callback) override {
+        return m_Timers.schedule(delay, std::move(callback));
+    }
+
+    bool cancelTimer(TimerId id) override {
+        return m_Timers.cancel(id);
+    }
+
+    size_t runTimers() override {
+        return m_Timers.advance();
     }
 
 private:
+    static constexpr int MAX_EVENTS = 256;
+
+    // Edge-triggered on every registration and update: a MOD that dropped EPOLLET would
+    // silently turn the fd level-triggered.
+    static uint32_t interestMask(bool read, bool write) {
+        uint32_t events = EPOLLET;
+        if (read) events |= EPOLLIN;
+        if (write) events |= EPOLLOUT;
+        return events;
+    }
     int m_EpollFd;
+    epoll_event m_Ready[MAX_EVENTS];
+    TimerWheel m_Timers;
 };
+
+std::unique_ptr<IEventLoop> createEpollEventLoop() {
+    return std::make_unique<EpollEventLoop>();
+}
@@ -1,17 +1,21 @@
 #include "event_loop_factory.h"
+#include <stdexcept>
 
+std::unique_ptr<IEventLoop> createEventLoop(ILogger& logger, const std::string& backend) {
 #ifdef __linux__
-#include "epoll_event_loop.cpp"
+    if (backend == "io_uring") {
+        try {
+            return createIoUringEventLoop();
+        } catch (const std::exception& ex) {
+            logger.logWarn(std::string("io_uring unavailable (") + ex.what() + "); falling back to epoll");
+        }
+    }
+    return createEpollEventLoop();
 #elif defined(__APPLE__)
-#include "kqueue_event_loop.cpp"
+    (void)logger;
+    (void)backend;
+    return createKqueueEventLoop();
 #else
 #error "Unsupported platform"
 #endif
-
-std::unique_ptr<IEventLoop> createEventLoop() {
-#ifdef __linux__
-    return std::make_unique<EpollEventLoop>();
-#elif defined(__APPLE__)
-    return std::make_unique<KqueueEventLoop>();
-#endif
 }
@@ -0,0 +1,222 @@
+#include "health_monitor.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+HealthMonitor::HealthMonitor(BackendPool& backends, const HealthCheckConfig& config, ILogger& logger)
+    : m_Backends(backends),
+      m_Config(config),
+      m_Interval(config.intervalMs),
+      m_Timeout(config.timeoutMs),
+      m_Logger(logger),
+      m_Probes(backends.size())
+{
+#ifdef __linux__
+    m_EventFd = ::epoll_create1(EPOLL_CLOEXEC);
+#endif
+    // Spread the first round over one interval; each backend keeps its phase after that.
+    auto now = Clock::now();
+    for (size_t id = 0; id < m_Probes.size(); ++id)
+        m_Probes[id].due = now + m_Interval * id / m_Probes.size();
+}
+
+HealthMonitor::~HealthMonitor() {
+    for (auto& probe : m_Probes) {
+        if (probe.fd >= 0)
+            ::close(probe.fd);
+    }
+    if (m_EventFd >= 0)
+        ::close(m_EventFd);
+}
+
+std::chrono::milliseconds HealthMonitor::tickInterval() const noexcept {
+    return std::clamp(std::min(m_Interval, m_Timeout) / 4, std::chrono::milliseconds(10),
+                      std::chrono::milliseconds(250));
+}
+
+// One comparison per backend per tick: thousands of backends are a few microseconds.
+void HealthMonitor::tick(Clock::time_point now) {
+    if (m_EventFd < 0)
+        return;
+    for (BackendId id = 0; id < m_Probes.size(); ++id) {
+        Probe& probe = m_Probes[id];
+        if (now < probe.due)
+            continue;
+        if (probe.phase == Phase::Idle)
+            start(id, now);
+        else
+            finish(id, false, now, "timed out");
+    }
+}
+
+void HealthMonitor::processEvents(Clock::time_point now) {
+#ifdef __linux__
+    if (m_EventFd < 0)
+        return;
+    epoll_event events[64];
+    int n;
+    do {
+        n = ::epoll_wait(m_EventFd, events, 64, 0);
+        for (int i = 0; i < n; ++i) {
+            auto id = static_cast<BackendId>(events[i].data.u64);
+            int fd = static_cast<int>(events[i].data.u64 >> 32);
+            // Skip an event for a probe that already finished (its fd may be reused).
+            if (id < m_Probes.size() && m_Probes[id].fd == fd && m_Probes[id].phase != Phase::Idle)
+                onReady(id, events[i].events, now);
+        }
+    } while (n == 64);
+#else
+    (void)now;
+#endif
+}
+
+void HealthMonitor::start(BackendId id, Clock::time_point now) {
+    Probe& probe = m_Probes[id];
+    const Backend& backend = m_Backends.at(id);
+    probe.reply.clear();
+    probe.due = now + m_Timeout;
+    if (!backend.isResolved()) {
+        finish(id, false, now, "unresolved address");
+        return;
+    }
+
+#ifdef __linux__
+    probe.fd = ::socket(backend.addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (probe.fd < 0) {
+        finish(id, false, now, "socket failed");
+        return;
+    }
+    int result;
+    while ((result = ::connect(probe.fd, reinterpret_cast<const sockaddr*>(&backend.addr), backend.addrLen)) < 0 &&
+           errno == EINTR) {}
+    if (result < 0 && errno != EINPROGRESS) {
+        finish(id, false, now, std::strerror(errno));
+        return;
+    }
+
+    probe.phase = Phase::Connecting;
+    arm(id, EPOLLOUT);
+#endif
+}
+
+void HealthMonitor::onReady(BackendId id, uint32_t events, Clock::time_point now) {
+#ifdef __linux__
+    Probe& probe = m_Probes[id];
+    if (probe.phase == Phase::Connecting) {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (::getsockopt(probe.fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0)
+            error = errno;
+        if (error != 0 || (events & EPOLLERR)) {
+            finish(id, false, now, error ? std::strerror(error) : "connect failed");
+            return;
+        }
+        if (!m_Config.send.empty() && !sendRequest(probe)) {
+            finish(id, false, now, "request not sent");
+            return;
+        }
+        if (m_Config.expect.empty()) {
+            finish(id, true, now, nullptr);
+            return;
+        }
+        probe.phase = Phase::Awaiting;
+        arm(id, EPOLLIN | EPOLLRDHUP);
+        return;
+    }
+
+    bool ok = false;
+    if (readReply(probe, ok))
+        finish(id, ok, now, ok ? nullptr : "unexpected reply");
+    else
+        arm(id, EPOLLIN | EPOLLRDHUP);
+#else
+    (void)id; (void)events; (void)now;
+#endif
+}
+
+// Probe requests are a few bytes: a fresh socket's send buffer takes them whole.
+bool HealthMonitor::sendRequest(Probe& probe) {
+    ssize_t sent;
+    while ((sent = ::send(probe.fd, m_Config.send.data(), m_Config.send.size(), 0)) < 0 &&
+           errno == EINTR) {}
+    return sent == static_cast<ssize_t>(m_Config.send.size());
+}
+
+bool HealthMonitor::readReply(Probe& probe, bool& ok) {
+    const std::string& expect = m_Config.expect;
+    char buf[512];
+    for (;;) {
+        size_t want = std::min(sizeof(buf), expect.size() - probe.reply.size());
+        ssize_t n = ::recv(probe.fd, buf, want, 0);
+        if (n > 0) {
+            probe.reply.append(buf, static_cast<size_t>(n));
+            if (expect.compare(0, probe.reply.size(), probe.reply) != 0) {
+                ok = false;
+                return true;
+            }
+            if (probe.reply.size() == expect.size()) {
+                ok = true;
+                return true;
+            }
+        } else if (n == 0) {
+            ok = false;   // closed before the full reply
+            return true;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return false;
+        } else if (errno != EINTR) {
+            ok = false;
+            return true;
+        }
+    }
+}
+
+// One-shot, so each readiness is reported once and the set has nothing left pending
+// when processEvents() returns (the reactor's watch on it is edge-triggered).
+void HealthMonitor::arm(BackendId id, uint32_t events) {
+#ifdef __linux__
+    Probe& probe = m_Probes[id];
+    epoll_event ev{};
+    ev.events = events | EPOLLONESHOT;
+    ev.data.u64 = static_cast<uint64_t>(probe.fd) << 32 | id;
+    if (::epoll_ctl(m_EventFd, EPOLL_CTL_MOD, probe.fd, &ev) < 0 && errno == ENOENT)
+        ::epoll_ctl(m_EventFd, EPOLL_CTL_ADD, probe.fd, &ev);
+#else
+    (void)id; (void)events;
+#endif
+}
+
+void HealthMonitor::finish(BackendId id, bool ok, Clock::time_point now, const char* reason) {
+    Probe& probe = m_Probes[id];
+    if (probe.fd >= 0) {
+        ::close(probe.fd);   // also drops it from the epoll set
+        probe.fd = -1;
+    }
+    probe.phase = Phase::Idle;
+    probe.due = now + m_Interval;
+
+    const Backend& backend = m_Backends.at(id);
+    bool healthy = m_Backends.isHealthy(id);
+    if (ok) {
+        probe.failures = 0;
+        probe.successes = std::min(probe.successes + 1, m_Config.healthyThreshold);
+        if (probe.successes == m_Config.healthyThreshold && !healthy) {
+            m_Backends.setHealthy(id, true);
+            m_Logger.logInfo("Backend " + backend.name + " is healthy again");
+        }
+        return;
+    }
+
+    probe.successes = 0;
+    m_Logger.logDebug("Health check of backend " + backend.name + " failed: " + reason);
+    probe.failures = std::min(probe.failures + 1, m_Config.unhealthyThreshold);
+    if (probe.failures == m_Config.unhealthyThreshold && healthy) {
+        m_Backends.setHealthy(id, false);
+        m_Logger.logError("Backend " + backend.name + " failed " + std::to_string(probe.failures) +
+                          " health checks; taking it out of rotation");
+    }
+}
@@ -0,0 +1,285 @@
+#include "event_loop_factory.h"
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+// Readiness-based IEventLoop on top of io_uring. Every fd carries one multishot
+// POLL_ADD, so re-arming after an event costs no syscall, and all register/update/
+// unregister requests queued during an iteration are submitted together with the
+// wait in a single io_uring_enter().
+class IoUringEventLoop : public IEventLoop {
+public:
+    IoUringEventLoop() {
+        io_uring_params params{};
+        params.flags = IORING_SETUP_CLAMP;
+        params.cq_entries = RING_ENTRIES * 4;
+        params.flags |= IORING_SETUP_CQSIZE;
+
+        m_RingFd = static_cast<int>(syscall(__NR_io_uring_setup, RING_ENTRIES, &params));
+        if (m_RingFd < 0)
+            throw std::runtime_error(std::string("io_uring_setup failed: ") + strerror(errno));
+
+        // EXT_ARG gives us a wait timeout without a TIMEOUT sqe; RSRC_TAGS (5.13)
+        // is the first feature bit shipped alongside multishot poll.
+        const unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP |
+                                  IORING_FEAT_EXT_ARG | IORING_FEAT_RSRC_TAGS;
+        if ((params.features & required) != required) {
+            ::close(m_RingFd);
+            throw std::runtime_error("io_uring: kernel lacks multishot poll / EXT_ARG support");
+        }
+
+        m_RingSize = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                              params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+        m_Ring = mmap(nullptr, m_RingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      m_RingFd, IORING_OFF_SQ_RING);
+        if (m_Ring == MAP_FAILED) {
+            ::close(m_RingFd);
+            throw std::runtime_error("io_uring: failed to map rings");
+        }
+
+        m_SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        m_Sqes = static_cast<io_uring_sqe*>(mmap(nullptr, m_SqesSize, PROT_READ | PROT_WRITE,
+                                                 MAP_SHARED | MAP_POPULATE, m_RingFd, IORING_OFF_SQES));
+        if (m_Sqes == MAP_FAILED) {
+            munmap(m_Ring, m_RingSize);
+            ::close(m_RingFd);
+            throw std::runtime_error("io_uring: failed to map sqes");
+        }
+
+        auto* base = static_cast<char*>(m_Ring);
+        m_SqHead = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+        m_SqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+        m_SqMask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+        m_SqEntries = params.sq_entries;
+        m_SqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+        m_CqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+        m_CqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+        m_CqMask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+        m_Cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+    }
+
+    ~IoUringEventLoop() override {
+        munmap(m_Sqes, m_SqesSize);
+        munmap(m_Ring, m_RingSize);
+        closeLoop();
+    }
+
+    bool registerFd(int fd, bool read, bool write) override {
+        if (fd < 0) return false;
+        FdState& st = state(fd);
+        if (st.armed)
+            disarm(fd, st);   // fd number was closed and reused without unregisterFd
+        st.mask = toPollMask(read, write);
+        arm(fd, st);
+        return true;
+    }
+
+    bool unregisterFd(int fd) override {
+        if (fd < 0 || static_cast<size_t>(fd) >= m_Fds.size() || !m_Fds[fd].armed)
+            return false;
+        disarm(fd, m_Fds[fd]);
+        return true;
+    }
+
+    void updateFd(int fd, bool wantRead, bool wantWrite) override {
+        if (fd < 0 || static_cast<size_t>(fd) >= m_Fds.size() || !m_Fds[fd].armed)
+            return;
+        FdState& st = m_Fds[fd];
+        disarm(fd, st);
+        st.mask = toPollMask(wantRead, wantWrite);
+        arm(fd, st);
+    }
+
+    int wait(std::vector<Event>& events, int timeoutMs) override {
+        events.clear();
+        if (m_RingFd < 0) return -1;
+
+        timeoutMs = m_Timers.nextTimeoutMs(timeoutMs);
+        if (!hasCompletions()) {
+            __kernel_timespec ts{};
+            io_uring_getevents_arg arg{};
+            if (timeoutMs >= 0) {
+                ts.tv_sec = timeoutMs / 1000;
+                ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000000;
+                arg.ts = reinterpret_cast<__u64>(&ts);
+            }
+            int rc = enter(m_Pending, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+            if (rc < 0 && errno != ETIME && errno != EINTR && errno != EBUSY)
+                return -1;
+        } else if (m_Pending > 0) {
+            enter(m_Pending, 0, 0, nullptr, 0);
+        }
+
+        unsigned head = *m_CqHead;
+        unsigned tail = std::atomic_ref<unsigned>(*m_CqTail).load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = m_Cqes[head & m_CqMask];
+            handleCompletion(cqe, events);
+        }
+        std::atomic_ref<unsigned>(*m_CqHead).store(head, std::memory_order_release);
+        return static_cast<int>(events.size());
+    }
+
+    void closeLoop() override {
+        if (m_RingFd >= 0) {
+            ::close(m_RingFd);
+            m_RingFd = -1;
+        }
+    }
+
+    TimerId addTimer(std::chrono::milliseconds delay, TimerCallback callback) override {
+        return m_Timers.schedule(delay, std::move(callback));
+    }
+
+    bool cancelTimer(TimerId id) override {
+        return m_Timers.cancel(id);
+    }
+
+    size_t runTimers() override {
+        return m_Timers.advance();
+    }
+
+private:
+    static constexpr unsigned RING_ENTRIES = 1024;
+    static constexpr __u64 REMOVE_TAG = ~0ULL;
+
+    struct FdState {
+        uint32_t generation = 0;
+        uint32_t mask = 0;
+        bool armed = false;
+    };
+
+    static uint32_t toPollMask(bool read, bool write) {
+        uint32_t mask = EPOLLET | EPOLLRDHUP;
+        if (read)  mask |= EPOLLIN;
+        if (write) mask |= EPOLLOUT;
+        return mask;
+    }
+
+    static __u64 userData(int fd, uint32_t generation) {
+        return (static_cast<__u64>(generation) << 32) | static_cast<uint32_t>(fd);
+    }
+
+    FdState& state(int fd) {
+        if (static_cast<size_t>(fd) >= m_Fds.size())
+            m_Fds.resize(static_cast<size_t>(fd) * 2 + 1);
+        return m_Fds[fd];
+    }
+
+    void arm(int fd, FdState& st) {
+        ++st.generation;
+        st.armed = true;
+        io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = fd;
+        sqe->poll32_events = st.mask;
+        sqe->len = IORING_POLL_ADD_MULTI;
+        sqe->user_data = userData(fd, st.generation);
+    }
+
+    void disarm(int fd, FdState& st) {
+        io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = userData(fd, st.generation);
+        sqe->user_data = REMOVE_TAG;
+        st.armed = false;
+        ++st.generation;
+    }
+
+    io_uring_sqe* nextSqe() {
+        unsigned head = std::atomic_ref<unsigned>(*m_SqHead).load(std::memory_order_acquire);
+        unsigned tail = *m_SqTail;
+        if (tail - head >= m_SqEntries)
+            enter(m_Pending, 0, 0, nullptr, 0);
+
+        // No SQPOLL thread: the kernel only reads sqes inside io_uring_enter(), so the
+        // caller may still fill the entry after the tail is published.
+
+        unsigned index = tail & m_SqMask;
+        io_uring_sqe* sqe = &m_Sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        m_SqArray[index] = index;
+        std::atomic_ref<unsigned>(*m_SqTail).store(tail + 1, std::memory_order_release);
+        ++m_Pending;
+        return sqe;
+    }
+
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags, void* arg, size_t argSize) {
+        int rc = static_cast<int>(syscall(__NR_io_uring_enter, m_RingFd, toSubmit, minComplete, flags, arg, argSize));
+        if (rc >= 0)
+            m_Pending -= std::min(static_cast<unsigned>(rc), m_Pending);
+        return rc;
+    }
+
+    bool hasCompletions() const {
+        return *m_CqHead != std::atomic_ref<unsigned>(*m_CqTail).load(std::memory_order_acquire);
+    }
+
+    void handleCompletion(const io_uring_cqe& cqe, std::vector<Event>& events) {
+        if (cqe.user_data == REMOVE_TAG)
+            return;
+
+        int fd = static_cast<int>(cqe.user_data & 0xffffffffu);
+        uint32_t generation = static_cast<uint32_t>(cqe.user_data >> 32);
+        if (static_cast<size_t>(fd) >= m_Fds.size())
+            return;
+        FdState& st = m_Fds[fd];
+        if (!st.armed || st.generation != generation)
+            return;   // completion from a poll that was removed or replaced
+
+        Event e{};
+        e.fd = fd;
+        if (cqe.res < 0) {
+            // The poll itself failed (e.g. -EBADF: the fd was closed before the request
+            // ran). Re-arming would fail the same way on every wait, so report it once
+            // and leave the fd disarmed until it is registered again.
+            st.armed = false;
+            e.error = cqe.res != -ECANCELED;
+            if (!e.error) return;
+        } else {
+            if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                // The kernel dropped the multishot request (e.g. CQ overflow); re-arm it.
+                st.armed = false;
+                arm(fd, st);
+            }
+
+            uint32_t revents = static_cast<uint32_t>(cqe.res);
+            e.readable = revents & EPOLLIN;
+            e.writable = revents & EPOLLOUT;
+            e.error = revents & EPOLLERR;
+            e.closed = revents & EPOLLHUP;
+        }
+        events.push_back(e);
+    }
+
+    int m_RingFd{-1};
+    void* m_Ring{nullptr};
+    size_t m_RingSize{0};
+    io_uring_sqe* m_Sqes{nullptr};
+    size_t m_SqesSize{0};
+
+    unsigned* m_SqHead{nullptr};
+    unsigned* m_SqTail{nullptr};
+    unsigned* m_SqArray{nullptr};
+    unsigned m_SqMask{0};
+    unsigned m_SqEntries{0};
+    unsigned* m_CqHead{nullptr};
+    unsigned* m_CqTail{nullptr};
+    unsigned m_CqMask{0};
+    io_uring_cqe* m_Cqes{nullptr};
+
+    unsigned m_Pending{0};
+    std::vector<FdState> m_Fds;
+    TimerWheel m_Timers;
+};
+
+std::unique_ptr<IEventLoop> createIoUringEventLoop() {
+    return std::make_unique<IoUringEventLoop>();
+}
@@ -1,6 +1,7 @@
-#include "event_loop.h"
+#include "event_loop_factory.h"
 #include <sys/event.h>
 #include <unistd.h>
+#include <stdexcept>
 
 class KqueueEventLoop : public IEventLoop {
 public:
@@ -11,7 +12,7 @@ public:
     }
 
     ~KqueueEventLoop() override {
-        ::close(m_Kq);
+        closeLoop();
     }
 
     bool registerFd(int fd, bool read, bool write) override {
@@ -35,10 +36,11 @@ public:
     int wait(std::vector<Event>& events, int timeoutMs) override {
         constexpr int MAX_EVENTS = 256;
         struct kevent evList[MAX_EVENTS];
+        timeoutMs = m_Timers.nextTimeoutMs(timeoutMs);
         struct timespec ts{};
         ts.tv_sec = timeoutMs / 1000;
         ts.tv_nsec = (timeoutMs % 1000) * 1000000;
-        int n = kevent(m_Kq, nullptr, 0, evList, MAX_EVENTS, &ts);
+        int n = kevent(m_Kq, nullptr, 0, evList, MAX_EVENTS, timeoutMs < 0 ? nullptr : &ts);
         if (n < 0) return -1;
 
         events.clear();
@@ -55,7 +57,22 @@ public:
     }
 
     void closeLoop() override {
-        ::close(m_Kq);
+        if (m_Kq >= 0) {
+            ::close(m_Kq);
+            m_Kq = -1;
+        }
+    }
+
+    TimerId addTimer(std::chrono::milliseconds delay, TimerCallback callback) override {
+        return m_Timers.schedule(delay, std::move(callback));
+    }
+
+    bool cancelTimer(TimerId id) override {
+        return m_Timers.cancel(id);
+    }
+
+    size_t runTimers() override {
+        return m_Timers.advance();
     }
 
     void updateFd(int fd, bool wantRead, bool wantWrite) override {
@@ -69,5 +86,9 @@ public:
 }
 private:
     int m_Kq;
+    TimerWheel m_Timers;
 };
 
+std::unique_ptr<IEventLoop> createKqueueEventLoop() {
+    return std::make_unique<KqueueEventLoop>();
+}
@@ -0,0 +1,51 @@
+#include "maglev_table.h"
+#include <stdexcept>
+
+static uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// FNV-1a with a per-use seed, finalized so nearby names land far apart.
+static uint64_t hashName(const std::string& name, uint64_t seed) {
+    uint64_t hash = 0xCBF29CE484222325ull ^ seed;
+    for (unsigned char c : name) {
+        hash ^= c;
+        hash *= 0x100000001B3ull;
+    }
+    return mix(hash);
+}
+
+MaglevTable::MaglevTable(const std::vector<std::string>& names, size_t size) {
+    if (names.empty())
+        throw std::invalid_argument("Maglev table needs at least one backend");
+    if (size <= names.size())
+        throw std::invalid_argument("Maglev table must be larger than the backend count");
+
+    const size_t count = names.size();
+    std::vector<uint64_t> offset(count), skip(count), next(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        offset[i] = hashName(names[i], 0) % size;
+        skip[i] = hashName(names[i], 1) % (size - 1) + 1;
+    }
+
+    constexpr uint32_t EMPTY = UINT32_MAX;
+    m_Entries.assign(size, EMPTY);
+    size_t filled = 0;
+    for (;;) {
+        for (size_t i = 0; i < count; ++i) {
+            // Walk backend i's permutation to its next unclaimed slot.
+            size_t slot;
+            do {
+                slot = (offset[i] + next[i] * skip[i]) % size;
+                ++next[i];
+            } while (m_Entries[slot] != EMPTY);
+            m_Entries[slot] = static_cast<uint32_t>(i);
+            if (++filled == size)
+                return;
+        }
+    }
+}
@@ -1,19 +1,24 @@
 #include <atomic>
 #include <csignal>
 #include <memory>
+#include <algorithm>
 #include <thread>
 
 #include "acceptor.h"
 #include "event_loop.h"
 #include "logger.h"
 #include "reactor.h"
+#include "reactor_group.h"
 #include "config_manager.h"
 #include "router.h"
+#include "health_monitor.h"
 #include "backend_pool.h"
 #include "event_loop_factory.h"
 #include <interfaces/IConnection.h>
 #include "interfaces/ILogger.h"
 #include "connection_pool.h"
+#include "buffer_pool.h"
+#include "pool_warmer.h"
 
 static std::atomic<bool> g_Stop{false};
 static void handleSignal(int) { g_Stop.store(true, std::memory_order_relaxed); }
@@ -22,6 +27,7 @@ static void handleSignal(int) { g_Stop.store(true, std::memory_order_relaxed); }
 int main(int argc, char* argv[]) {
     std::signal(SIGINT,  handleSignal);
     std::signal(SIGTERM, handleSignal);
+    std::signal(SIGPIPE, SIG_IGN);   // a peer reset must surface as EPIPE, not kill the process
     try{
         const std::string configPath = (argc > 1) ? argv[1] : "config/config.json";
         auto configManager = ConfigManager(configPath);
@@ -30,36 +36,94 @@ int main(int argc, char* argv[]) {
         logger.logInfo("Starting load balancer...");
 
         BackendPool backendPool(cfg.backends);
-        Router router(backendPool);
-        auto loop = createEventLoop();
+        if (cfg.outlierDetection.enabled)
+            backendPool.enableOutlierDetection(cfg.outlierDetection);
+        Router router(backendPool, parseRoutingAlgorithm(cfg.routing.algorithm));
 
-        ConnectionPool connectionPool(cfg.connectionPool);
-        Reactor reactor(std::move(loop), static_cast<ILogger&>(logger), connectionPool);
-        reactor.setIdleTimeout(std::chrono::seconds(30));
-        Acceptor acceptor(cfg.listen, router, static_cast<ILogger&>(logger), connectionPool,
-             [&](std::shared_ptr<IConnection> conn, int clientFd, const BackendConfig& backend) {
-                if (!conn->connectToBackend()) {
+        size_t reactorCount = ReactorGroup::resolveThreadCount(cfg.reactor.threads);
+        // One shard per reactor: only reactor threads acquire and release pooled fds.
+        ConnectionPool connectionPool(cfg.connectionPool, backendPool.size(), reactorCount);
+        std::unique_ptr<BufferPool> bufferPool;
+        if (cfg.bufferPool.memoryBudgetBytes > 0) {
+            bufferPool = std::make_unique<BufferPool>(
+                std::max(cfg.reactor.connectionReadBuffer, cfg.reactor.connectionWriteBuffer),
+                cfg.bufferPool.memoryBudgetBytes, cfg.bufferPool.hugePages);
+            logger.logInfo("Buffer pool: " + std::to_string(bufferPool->capacity()) + " chunks of " +
+                           std::to_string(bufferPool->chunkSize()) + " bytes" +
+                           (bufferPool->usesHugePages() ? " (hugetlb)" : ""));
+        }
+        // Declared before the reactors, which call into it until they are stopped.
+        std::unique_ptr<HealthMonitor> healthMonitor;
+        if (cfg.healthCheck.enabled)
+            healthMonitor = std::make_unique<HealthMonitor>(backendPool, cfg.healthCheck, logger);
+        ReactorGroup reactors(reactorCount, static_cast<ILogger&>(logger), connectionPool,
+                              [&]() { return createEventLoop(logger, cfg.reactor.eventLoop); });
+        reactors.setIdleTimeout(std::chrono::seconds(cfg.reactor.idleTimeoutSeconds));
+        reactors.setConnectTimeout(std::chrono::milliseconds(cfg.reactor.connectTimeoutMs));
+        if (cfg.reactor.statsIntervalMs > 0)
+            reactors.enableStatsReport(std::chrono::milliseconds(cfg.reactor.statsIntervalMs));
+        reactors.at(0).enablePoolMaintenance(std::chrono::milliseconds(cfg.connectionPool.reapIntervalMs));
+        if (healthMonitor)
+            reactors.at(0).enableHealthChecks(*healthMonitor);
+        auto makeAcceptCallback = [&](Reactor* owner) {
+            return [&, owner](std::shared_ptr<IConnection> conn, int clientFd, const Backend&) {
+                // The backend connect is issued by the owning reactor, never here. A
+                // reuseport acceptor already runs on its reactor's thread; the shared
+                // acceptor thread must hand off through the reactor's mailbox.
+                if (owner) {
+                    owner->openConnection(conn);
+                } else if (!reactors.next().dispatchConnection(conn)) {
+                    logger.logError("Reactor mailbox full; dropping connection fd=" + std::to_string(clientFd));
                     conn->closeAll();
-                    return;
                 }
-                reactor.registerConnection(conn, clientFd, conn->getBackendFd());
-            }
-        ); 
-        acceptor.start();       
-        logger.logInfo("Acceptor started; entering Reactor event loop");
+            };
+        };
+
+        ConnectionOptions connectionOptions;
+        connectionOptions.useSplice = cfg.reactor.forwarding == "splice";
+        connectionOptions.readBufferSize = cfg.reactor.connectionReadBuffer;
+        connectionOptions.writeBufferSize = cfg.reactor.connectionWriteBuffer;
+        connectionOptions.bufferPool = bufferPool.get();
+        connectionOptions.connectionPool = &connectionPool;
+        connectionOptions.reuseBackend = cfg.connectionPool.reuseBackendConnections;
 
+        // reusePort: every reactor owns a SO_REUSEPORT listener in its own loop and the
+        // kernel spreads connections; otherwise a single acceptor thread hands them out.
+        std::vector<std::unique_ptr<Acceptor>> acceptors;
+        if (cfg.listen.reusePort) {
+            for (size_t i = 0; i < reactors.size(); ++i) {
+                Reactor& reactor = reactors.at(i);
+                auto acceptor = std::make_unique<Acceptor>(cfg.listen, router, static_cast<ILogger&>(logger),
+                                                           connectionPool, makeAcceptCallback(&reactor));
+                acceptor->setConnectionOptions(connectionOptions);
+                acceptor->attachEventLoop(reactor.eventLoop());
+                Acceptor* raw = acceptor.get();
+                reactor.registerHandler(raw->getListenFd(), [raw](const Event&) { raw->acceptPending(); });
+                acceptors.push_back(std::move(acceptor));
+            }
+        } else {
+            acceptors.push_back(std::make_unique<Acceptor>(cfg.listen, router, static_cast<ILogger&>(logger),
+                                                           connectionPool, makeAcceptCallback(nullptr)));
+            acceptors.back()->setConnectionOptions(connectionOptions);
+        }
 
-        std::thread reactorThread([&](){ reactor.run(); });
+        PoolWarmer poolWarmer(connectionPool, backendPool, cfg.connectionPool, logger);
+        poolWarmer.start();
+        reactors.start();
+        if (!cfg.listen.reusePort)
+            acceptors.front()->start();
+        logger.logInfo("Accepting on " + std::to_string(acceptors.size()) + " listener(s); dispatching to " +
+                       std::to_string(reactors.size()) + " reactor(s)");
 
         while (!g_Stop.load(std::memory_order_relaxed)) {
             std::this_thread::sleep_for(std::chrono::milliseconds(200));
         }
         logger.logInfo("Shutdown signal received");
 
-        acceptor.stop();    
-        reactor.stop();    
-
-        if (reactorThread.joinable()) reactorThread.join();
+        for (auto& acceptor : acceptors)
+            acceptor->stop();
+        poolWarmer.stop();
+        reactors.stop();    
 
         logger.logInfo("Load balancer stopped gracefully");
         return 0;
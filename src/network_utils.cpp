@@ -1,16 +1,16 @@
 #include "network_utils.h"
 #include <sys/socket.h>
-#include <sys/select.h>
+#include <poll.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
 #include <cstring>
 
-int connectWithTimeout(int fd, const sockaddr_in& addr, int timeoutMs) {
+int connectWithTimeout(int fd, const sockaddr* addr, socklen_t addrLen, int timeoutMs) {
     int flags = fcntl(fd, F_GETFL, 0);
     fcntl(fd, F_SETFL, flags | O_NONBLOCK);
 
-    int result = ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+    int result = ::connect(fd, addr, addrLen);
     if (result == 0) {
         fcntl(fd, F_SETFL, flags);
         return 0;
@@ -20,15 +20,9 @@ int connectWithTimeout(int fd, const sockaddr_in& addr, int timeoutMs) {
         return -1;
     }
 
-    fd_set writefds;
-    FD_ZERO(&writefds);
-    FD_SET(fd, &writefds);
-
-    struct timeval tv;
-    tv.tv_sec = timeoutMs / 1000;
-    tv.tv_usec = (timeoutMs % 1000) * 1000;
-
-    result = select(fd + 1, nullptr, &writefds, nullptr, &tv);
+    // poll rather than select: fds at or above FD_SETSIZE are fine.
+    pollfd pfd{fd, POLLOUT, 0};
+    while ((result = poll(&pfd, 1, timeoutMs)) < 0 && errno == EINTR) {}
     if (result <= 0) {
         errno = (result == 0) ? ETIMEDOUT : errno;
         return -1;
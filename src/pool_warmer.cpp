@@ -0,0 +1,93 @@
+#include "pool_warmer.h"
+#include <algorithm>
+#include <cmath>
+
+// How quickly the rate estimate follows demand; short enough to track a ramp within a
+// few passes, long enough that one quiet interval does not drain the warm set.
+static constexpr double RATE_TIME_CONSTANT_SECONDS = 3.0;
+// Keep enough idle connections for this many intervals' worth of acquires.
+static constexpr double HEADROOM = 2.0;
+
+PoolWarmer::PoolWarmer(ConnectionPool& pool, BackendPool& backends, const ConnectionPoolConfig& config,
+                       ILogger& logger)
+    : m_Pool(pool),
+      m_Backends(backends),
+      m_Config(config),
+      m_Logger(logger),
+      m_Rate(backends.size(), 0.0) {}
+
+PoolWarmer::~PoolWarmer() {
+    stop();
+}
+
+void PoolWarmer::start() {
+    if (m_Thread.joinable() || m_Config.maxIdle == 0)
+        return;
+    m_Stopping = false;
+    m_Thread = std::thread([this]() { run(); });
+}
+
+void PoolWarmer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_Wake.notify_all();
+    if (m_Thread.joinable())
+        m_Thread.join();
+}
+
+void PoolWarmer::run() {
+    auto interval = std::chrono::milliseconds(m_Config.maintenanceIntervalMs);
+    auto last = std::chrono::steady_clock::now();
+    runOnce(std::chrono::duration<double>(0));
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while (!m_Wake.wait_for(lock, interval, [this]() { return m_Stopping; })) {
+        lock.unlock();
+        auto now = std::chrono::steady_clock::now();
+        runOnce(now - last);
+        last = now;
+        lock.lock();
+    }
+}
+
+size_t PoolWarmer::targetIdle(BackendId id) const {
+    double perInterval = m_Rate[id] * m_Config.maintenanceIntervalMs / 1000.0;
+    // Rounded rather than ceiled, so a decayed trickle of demand settles back to minIdle.
+    auto wanted = static_cast<size_t>(std::lround(perInterval * HEADROOM));
+    return std::clamp(wanted, m_Config.minIdle, m_Config.maxIdle);
+}
+
+void PoolWarmer::runOnce(std::chrono::duration<double> elapsed) {
+    double seconds = elapsed.count();
+    std::vector<ConnectionPool::DialRequest> dials;
+    std::vector<size_t> targets;
+    for (BackendId id = 0; id < m_Backends.size(); ++id) {
+        const Backend& backend = m_Backends.at(id);
+        size_t demand = m_Pool.takeDemand(backend);
+        if (seconds > 0) {
+            double alpha = 1.0 - std::exp(-seconds / RATE_TIME_CONSTANT_SECONDS);
+            m_Rate[id] += alpha * (demand / seconds - m_Rate[id]);
+        }
+
+        size_t target = targetIdle(id);
+        size_t idle = m_Pool.idleCount(backend);
+        if (idle > m_Config.maxIdle)
+            m_Pool.trimIdle(backend, m_Config.maxIdle);
+        if (idle < target) {
+            dials.push_back({&backend, target - idle});
+            targets.push_back(target);
+        }
+    }
+
+    // Every backend's top-up in one batch: a blackholed backend costs the pass one
+    // connect timeout, not one per backend queued behind it. Backends that are down or
+    // at their cap come back short and are tried again next pass.
+    m_Pool.addNewConnections(dials);
+    for (size_t i = 0; i < dials.size(); ++i) {
+        if (dials[i].dialed > 0)
+            m_Logger.logDebug("Prewarmed " + std::to_string(dials[i].dialed) + " connection(s) to " +
+                              dials[i].backend->name + " (target " + std::to_string(targets[i]) + ")");
+    }
+}
@@ -1,125 +1,492 @@
 #include "reactor.h"
 #include "event_loop_factory.h"
+#include "health_monitor.h"
 #include <unistd.h>
 #include <sys/socket.h>
+#include <cerrno>
 #include <cstring>
 #include <iostream>
 #include <thread>
 #include <atomic>
+#include <algorithm>
+#include <fcntl.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+Reactor::Reactor(std::unique_ptr<IEventLoop> loop, ILogger& logger, ConnectionPool& connectionPool,
+                 size_t mailboxCapacity)
+    : m_Loop(std::move(loop)),
+      m_ConnectionPool(connectionPool),
+      m_Logger(logger),
+      m_Mailbox(mailboxCapacity)
+{
+#ifdef __linux__
+    m_WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    m_WakeWriteFd = m_WakeFd;
+#else
+    int fds[2];
+    if (pipe(fds) == 0) {
+        fcntl(fds[0], F_SETFL, O_NONBLOCK);
+        fcntl(fds[1], F_SETFL, O_NONBLOCK);
+        m_WakeFd = fds[0];
+        m_WakeWriteFd = fds[1];
+    }
+#endif
+    if (m_WakeFd < 0)
+        throw std::runtime_error("Failed to create reactor wakeup fd");
+
+    registerHandler(m_WakeFd, [this](const Event&) {
+#ifdef __linux__
+        uint64_t count;
+        while (::read(m_WakeFd, &count, sizeof(count)) > 0) {}
+#else
+        char buf[64];
+        while (::read(m_WakeFd, buf, sizeof(buf)) > 0) {}
+#endif
+    });
+}
 
 Reactor::~Reactor() {
     stop();
+    closeConnections();
+    m_Loop->closeLoop();
+    if (m_WakeWriteFd >= 0 && m_WakeWriteFd != m_WakeFd)
+        ::close(m_WakeWriteFd);
+    if (m_WakeFd >= 0)
+        ::close(m_WakeFd);
+}
+
+bool Reactor::post(Task task) {
+    if (!m_Mailbox.tryPush(std::move(task)))
+        return false;
+    wakeup();
+    return true;
+}
+
+bool Reactor::dispatchConnection(std::shared_ptr<IConnection> conn) {
+    return post([this, conn = std::move(conn)]() mutable { openConnection(std::move(conn)); });
+}
+
+void Reactor::openConnection(std::shared_ptr<IConnection> conn) {
+    int pooledFd = -1;
+    if (m_ConnectionPool.admit(conn->getBackend(), pooledFd) == ConnectionPool::Admission::Full)
+        parkConnection(std::move(conn));
+    else
+        startBackend(std::move(conn), pooledFd);
+}
+
+// The backend is at its concurrency cap: queue for the next free slot. The grant
+// arrives on the thread that freed it and comes back here through the mailbox; the
+// deadline timer only holds a weak reference, the queue entry owns the connection.
+// While queued the client fd is watched so a hangup gives its place back at once.
+void Reactor::parkConnection(std::shared_ptr<IConnection> conn) {
+    const Backend& backend = conn->getBackend();
+    int clientFd = conn->getClientFd();
+    int pooledFd = -1;
+    ConnectionPool::WaitTicket ticket = 0;
+    std::weak_ptr<IConnection> weak = conn;
+    auto onGrant = [this, conn](int fd) {
+        if (post([this, conn, fd]() {
+                unregisterHandler(conn->getClientFd());
+                startBackend(conn, fd);
+            }))
+            return;
+        m_Logger.logError("Reactor mailbox full; dropping queued connection fd=" + std::to_string(conn->getClientFd()));
+        if (fd >= 0)
+            m_ConnectionPool.release(conn->getBackend(), fd);
+        else
+            m_ConnectionPool.releaseSlot(conn->getBackend());
+        conn->closeAll();
+    };
+
+    switch (m_ConnectionPool.wait(backend, std::move(onGrant), pooledFd, ticket)) {
+    case ConnectionPool::Admission::Granted:
+        startBackend(std::move(conn), pooledFd);
+        return;
+    case ConnectionPool::Admission::Queued:
+        m_Loop->addTimer(m_ConnectionPool.waitTimeout(), [this, weak, ticket, clientFd]() {
+            auto parked = weak.lock();
+            if (parked && m_ConnectionPool.cancelWait(parked->getBackend(), ticket)) {
+                m_Logger.logError("Timed out waiting for backend " + parked->getBackend().name +
+                                  "; closing client fd=" + std::to_string(clientFd));
+                unregisterHandler(clientFd);
+                parked->closeAll();
+            }
+        });
+        registerHandler(clientFd, [this, weak, ticket, clientFd](const Event& e) {
+            onParkedClientEvent(e, clientFd, ticket, weak);
+        });
+        m_Logger.logDebug("Backend " + backend.name + " at capacity; queued client fd=" +
+                          std::to_string(clientFd));
+        return;
+    default:
+        m_Logger.logError("Backend " + backend.name + " at capacity; refusing client fd=" +
+                          std::to_string(clientFd));
+        conn->closeAll();
+        return;
+    }
+}
+
+// Arguments are copies: unregistering the handler destroys the lambda that called us.
+void Reactor::onParkedClientEvent(Event e, int clientFd, ConnectionPool::WaitTicket ticket,
+                                  std::weak_ptr<IConnection> weak) {
+    if (!e.error && !e.closed) {
+        // Early request bytes stay queued for the backend; only EOF means the client left.
+        char byte;
+        ssize_t n = ::recv(clientFd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)))
+            return;
+    }
+
+    // Stop watching either way: if the grant already fired, startBackend registers the
+    // fd again and the hangup is handled as a normal close.
+    unregisterHandler(clientFd);
+    auto parked = weak.lock();
+    if (parked && m_ConnectionPool.cancelWait(parked->getBackend(), ticket)) {
+        m_Logger.logDebug("Queued client fd=" + std::to_string(clientFd) + " hung up; leaving wait queue");
+        parked->closeAll();
+    }
+}
+
+// `pooledFd` is a lent pool connection, or -1 to dial (the new fd is then adopted so
+// closing it frees the admission slot).
+void Reactor::startBackend(std::shared_ptr<IConnection> conn, int pooledFd) {
+    if (pooledFd >= 0)
+        conn->adoptBackendFd(pooledFd);
+    if (!conn->connectToBackend()) {
+        m_Logger.logError("Could not start backend connect for client fd=" + std::to_string(conn->getClientFd()));
+        m_ConnectionPool.releaseSlot(conn->getBackend());
+        conn->closeAll();
+        return;
+    }
+    if (pooledFd < 0)
+        m_ConnectionPool.adopt(conn->getBackend(), conn->getBackendFd());
+    int clientFd = conn->getClientFd();
+    int backendFd = conn->getBackendFd();
+    registerConnection(std::move(conn), clientFd, backendFd);
+}
+
+void Reactor::wakeup() {
+    // Coalesce: one eventfd write per drain, however many producers post.
+    if (m_WakePending.exchange(true, std::memory_order_acq_rel))
+        return;
+#ifdef __linux__
+    uint64_t one = 1;
+    ssize_t rc = ::write(m_WakeWriteFd, &one, sizeof(one));
+#else
+    char one = 1;
+    ssize_t rc = ::write(m_WakeWriteFd, &one, 1);
+#endif
+    (void)rc;
+}
+
+void Reactor::drainTasks() {
+    // An RMW, not a store: it reads the last producer's exchange(true), so every push that
+    // skipped the eventfd write is visible to the tryPop below (a plain store could let
+    // the pops be reordered ahead of it and strand a task until the next timeout).
+    m_WakePending.exchange(false, std::memory_order_acq_rel);
+    Task task;
+    while (m_Mailbox.tryPop(task)) {
+        task();
+        task = nullptr;
+    }
+}
+
+static constexpr size_t INITIAL_SLOTS = 1024;
+
+void Reactor::setSlot(int fd, std::shared_ptr<IConnection> conn) {
+    if (fd < 0) return;
+    if (static_cast<size_t>(fd) >= m_Slots.size())
+        m_Slots.resize(std::max(static_cast<size_t>(fd) + 1, std::max(m_Slots.size() * 2, INITIAL_SLOTS)));
+    clearSlot(fd);
+    m_Slots[fd].conn = std::move(conn);
+}
+
+void Reactor::clearSlot(int fd) {
+    if (fd < 0 || static_cast<size_t>(fd) >= m_Slots.size())
+        return;
+    Slot& slot = m_Slots[fd];
+    if (slot.timer != INVALID_TIMER_ID) {
+        m_Loop->cancelTimer(slot.timer);
+        slot.timer = INVALID_TIMER_ID;
+    }
+    slot.conn.reset();
+}
+
+void Reactor::armTimer(int fd, std::chrono::milliseconds delay, TimerKind kind) {
+    Slot& slot = m_Slots[fd];
+    if (slot.timer != INVALID_TIMER_ID)
+        m_Loop->cancelTimer(slot.timer);
+    // Small capture so std::function stays in its inline buffer (no allocation per timer).
+    slot.timer = m_Loop->addTimer(delay, [this, fd, kind]() {
+        m_Slots[fd].timer = INVALID_TIMER_ID;
+        if (kind == TimerKind::Idle)
+            onIdleTimer(fd);
+        else
+            onConnectTimer(fd);
+    });
 }
 
 void Reactor::registerConnection(std::shared_ptr<IConnection> conn, int clientFd, int backendFd) {
-    m_Connections[clientFd] = conn;
-    m_Connections[backendFd] = conn;
+    setSlot(clientFd, conn);
+    setSlot(backendFd, conn);
     m_Loop->registerFd(clientFd, true, false);
     m_Loop->registerFd(backendFd, true, true);
+    conn->attachEventLoop(m_Loop.get());
+    if (m_IdleTimeout.count() > 0 && clientFd >= 0)
+        armTimer(clientFd, m_IdleTimeout, TimerKind::Idle);
+    if (m_ConnectTimeout.count() > 0 && backendFd >= 0 && !conn->isConnected())
+        armTimer(backendFd, m_ConnectTimeout, TimerKind::Connect);
     m_Logger.logInfo("Registered connection: clientFd=" + std::to_string(clientFd) +
                   " backendFd=" + std::to_string(backendFd));
 }
 
 void Reactor::unregisterConnection(int fd) {
     m_Loop->unregisterFd(fd);
-    m_Connections.erase(fd);
+    clearSlot(fd);
     m_Logger.logDebug("Unregistered fd=" + std::to_string(fd));
 }
 
+bool Reactor::registerHandler(int fd, FdHandler handler) {
+    m_Handlers[fd] = std::move(handler);
+    if (!m_Loop->registerFd(fd, true, false)) {
+        m_Handlers.erase(fd);
+        m_Logger.logError("Failed to register handler for fd=" + std::to_string(fd));
+        return false;
+    }
+    return true;
+}
+
+void Reactor::unregisterHandler(int fd) {
+    m_Loop->unregisterFd(fd);
+    m_Handlers.erase(fd);
+}
+
+void Reactor::enablePoolMaintenance(std::chrono::milliseconds interval) {
+    int watchFd = m_ConnectionPool.watchFd();
+    if (watchFd >= 0) {
+        registerHandler(watchFd, [this](const Event&) {
+            size_t closed = m_ConnectionPool.reapClosed();
+            if (closed > 0)
+                m_Logger.logDebug("Evicted " + std::to_string(closed) + " pooled connection(s) closed by backend");
+        });
+    }
+    m_PoolSweepInterval = interval;
+    armPoolSweep();
+}
+
+void Reactor::armPoolSweep() {
+    m_Loop->addTimer(m_PoolSweepInterval, [this]() {
+        size_t closed = m_ConnectionPool.cleanupIdleConnections();
+        if (closed > 0)
+            m_Logger.logDebug("Expired " + std::to_string(closed) + " idle pooled connection(s)");
+        armPoolSweep();
+    });
+}
+
+void Reactor::enableHealthChecks(HealthMonitor& monitor) {
+    int eventFd = monitor.eventFd();
+    if (eventFd < 0) {
+        m_Logger.logError("Health checks are not supported on this platform; all backends stay in rotation");
+        return;
+    }
+    registerHandler(eventFd, [&monitor](const Event&) { monitor.processEvents(); });
+    armHealthTick(monitor);
+}
+
+void Reactor::armHealthTick(HealthMonitor& monitor) {
+    m_Loop->addTimer(monitor.tickInterval(), [this, &monitor]() {
+        monitor.tick();
+        armHealthTick(monitor);
+    });
+}
+
+Reactor::Stats Reactor::stats() const {
+    Stats stats;
+    for (size_t fd = 0; fd < m_Slots.size(); ++fd) {
+        IConnection* conn = m_Slots[fd].conn.get();
+        if (!conn)
+            continue;
+        // A connection holds up to two slots; count it at the lower one it still owns.
+        int other = static_cast<int>(fd) == conn->getClientFd() ? conn->getBackendFd() : conn->getClientFd();
+        if (other >= 0 && static_cast<size_t>(other) < fd && connectionAt(other) == conn)
+            continue;
+        ++stats.connections;
+        stats.stateBytes += conn->stateBytes();
+    }
+    return stats;
+}
+
+void Reactor::enableStatsReport(std::chrono::milliseconds interval) {
+    m_StatsInterval = interval;
+    armStatsReport();
+}
+
+void Reactor::armStatsReport() {
+    m_Loop->addTimer(m_StatsInterval, [this]() {
+        Stats current = stats();
+        m_Logger.logInfo("Reactor stats: connections=" + std::to_string(current.connections) +
+                         " stateBytes=" + std::to_string(current.stateBytes) +
+                         " slots=" + std::to_string(m_Slots.size()));
+        armStatsReport();
+    });
+}
+
 void Reactor::run() {
     m_Running = true;
     m_Logger.logInfo("Reactor started");
 
     std::vector<Event> events;
 
-    while (m_Running) {
+    while (!m_StopRequested.load(std::memory_order_acquire)) {
         int n = m_Loop->wait(events, 1000);
-        if (n <= 0) continue;
-
-        for (auto& e : events)
-            handleEvent(e);
+        for (int i = 0; i < n; ++i)
+            handleEvent(events[i]);
+        // Only once the batch is dispatched: a timer may close an fd still listed in it.
+        m_Loop->runTimers();
+        drainTasks();
     }
 
+    m_Running = false;
+
     m_Logger.logInfo("Reactor stopped");
 }
 
 void Reactor::handleEvent(Event& e) {
-    auto it = m_Connections.find(e.fd);
-    if (it == m_Connections.end()) return;
-    auto conn = it->second;
+    IConnection* conn = connectionAt(e.fd);
+    if (!conn) {
+        auto handler = m_Handlers.find(e.fd);
+        if (handler != m_Handlers.end())
+            handler->second(e);
+        return;
+    }
+
+    if ((e.error || e.closed) && !conn->isConnected() && e.fd == conn->getBackendFd()) {
+        m_Logger.logError("Backend connection failed (fd=" + std::to_string(e.fd) + ")");
+        conn->noteBackendFailure();
+        closeConnection(conn);
+        return;
+    }
 
     if (e.error || e.closed) {
+        // Unregistering drops the slot's reference; keep the connection alive until we're done.
+        std::shared_ptr<IConnection> owner = m_Slots[e.fd].conn;
         m_Logger.logDebug("Error/Close event on fd=" + std::to_string(e.fd));
         m_Logger.logDebug("Error: " + std::string(strerror(errno)));
+        if (e.error && e.fd == conn->getBackendFd())
+            conn->noteBackendFailure();   // reset by the backend
+        int clientFd = conn->getClientFd();
+        int backendFd = conn->getBackendFd();
         conn->onClose(e.fd);
-
-        if (conn->isClientFd(e.fd) && conn->hasBackendOpen()) {
-            m_ConnectionPool.release(conn->getBackendConfig(), conn->getBackendFd());
-        }
-
         unregisterConnection(e.fd);
+        dropClosedFds(conn, clientFd, backendFd);
         return;
     }
 
+    // Captured so fds the connection closes itself (EOF, send/recv errors) can be dropped.
+    int clientFd = conn->getClientFd();
+    int backendFd = conn->getBackendFd();
+
     if (e.writable) {
         if (!conn->isConnected() && e.fd == conn->getBackendFd()) {
             int err = 0;
             socklen_t len = sizeof(err);
             getsockopt(e.fd, SOL_SOCKET, SO_ERROR, &err, &len);
             if (err != 0) {
+                // The client never got a backend: drop it too rather than leave it parked.
                 m_Logger.logError("Backend connection failed: " + std::string(strerror(err)));
-                conn->onClose(e.fd);
-                unregisterConnection(e.fd);
+                conn->noteBackendFailure();
+                closeConnection(conn);
                 return;
             }
 
             conn->setConnected(true);
+            if (m_Slots[e.fd].timer != INVALID_TIMER_ID) {
+                m_Loop->cancelTimer(m_Slots[e.fd].timer);
+                m_Slots[e.fd].timer = INVALID_TIMER_ID;
+            }
             m_Logger.logInfo("Backend connection established successfully (fd=" + std::to_string(e.fd) + ")");
-
-            m_Loop->updateFd(e.fd, true, false);
-        } else {
-            conn->onWritable(e.fd);
         }
+        // Also flushes whatever the client sent while the connect was pending and drops
+        // write interest once nothing is queued.
+        conn->onWritable(e.fd);
     }
 
     if (e.readable)
         conn->onReadable(e.fd);
+
+    if (conn->getClientFd() != clientFd || conn->getBackendFd() != backendFd)
+        dropClosedFds(conn, clientFd, backendFd);
+}
+
+void Reactor::dropClosedFds(IConnection* conn, int clientFd, int backendFd) {
+    std::shared_ptr<IConnection> owner;
+    for (int fd : {clientFd, backendFd}) {
+        if (fd < 0 || fd == conn->getClientFd() || fd == conn->getBackendFd() || connectionAt(fd) != conn)
+            continue;
+        if (!owner)
+            owner = m_Slots[fd].conn;
+        clearSlot(fd);
+    }
 }
 
 void Reactor::stop() {
-    m_Running = false;
-    m_Loop->closeLoop();
+    // The loop itself is closed by the destructor, once run() can no longer be inside wait().
+    m_StopRequested.store(true, std::memory_order_release);
+    wakeup();
+}
+
+// Closing a backend fd can hand its slot to a client parked on any reactor, so a
+// group drops all connections while every reactor is still alive.
+void Reactor::closeConnections() {
+    for (size_t fd = 0; fd < m_Slots.size(); ++fd)
+        clearSlot(static_cast<int>(fd));
 }
 
 void Reactor::setIdleTimeout(std::chrono::seconds timeout) {
     m_IdleTimeout = timeout;
+}
 
-    if (m_IdleThread.joinable()) {
-        m_StopIdleMonitor = true;
-        m_IdleThread.join();
-    }
+void Reactor::setConnectTimeout(std::chrono::milliseconds timeout) {
+    m_ConnectTimeout = timeout;
+}
 
-    if (timeout.count() > 0) {
-        m_StopIdleMonitor = false;
-        m_IdleThread = std::thread(&Reactor::monitorIdleConnections, this);
+void Reactor::closeConnection(IConnection* conn) {
+    std::shared_ptr<IConnection> owner;
+    for (int fd : {conn->getClientFd(), conn->getBackendFd()}) {
+        if (connectionAt(fd) != conn)
+            continue;
+        if (!owner)
+            owner = m_Slots[fd].conn;
+        unregisterConnection(fd);
     }
+    conn->closeAll();
 }
 
-void Reactor::monitorIdleConnections() {
-    m_Logger.logInfo("Idle monitor thread started");
-    while (!m_StopIdleMonitor) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+void Reactor::onIdleTimer(int clientFd) {
+    IConnection* conn = connectionAt(clientFd);
+    if (!conn)
+        return;
 
-        for (auto it = m_Connections.begin(); it != m_Connections.end();) {
-            auto conn = it->second;
-            if (conn->isIdleFor(m_IdleTimeout)) {
-                m_Logger.logInfo("Closing idle connection fd=" + std::to_string(it->first));
-                conn->onClose(it->first);
-                it = m_Connections.erase(it);
-            } else {
-                ++it;
-            }
-        }
+    auto idle = std::chrono::steady_clock::now() - conn->getLastActivity();
+    if (idle < m_IdleTimeout) {
+        // Activity since the timer was armed: sleep for the remainder instead of rescanning.
+        armTimer(clientFd, std::chrono::ceil<std::chrono::milliseconds>(m_IdleTimeout - idle),
+                 TimerKind::Idle);
+        return;
     }
-    m_Logger.logInfo("Idle monitor thread stopped");
-}
\ No newline at end of file
+
+    m_Logger.logInfo("Closing idle connection fd=" + std::to_string(clientFd));
+    closeConnection(conn);
+}
+
+void Reactor::onConnectTimer(int backendFd) {
+    IConnection* conn = connectionAt(backendFd);
+    if (!conn || conn->isConnected())
+        return;
+
+    m_Logger.logError("Backend connect timed out (fd=" + std::to_string(backendFd) + ")");
+    conn->noteBackendFailure();
+    closeConnection(conn);
+}
@@ -0,0 +1,122 @@
+#include "reactor_group.h"
+#include <fstream>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+ReactorGroup::ReactorGroup(size_t count,
+                           ILogger& logger,
+                           ConnectionPool& connectionPool,
+                           LoopFactory loopFactory)
+    : m_Logger(logger)
+{
+    if (count == 0)
+        throw std::runtime_error("ReactorGroup requires at least one reactor");
+
+    m_Reactors.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        m_Reactors.push_back(std::make_unique<Reactor>(loopFactory ? loopFactory() : createEventLoop(logger),
+                                                       logger, connectionPool));
+}
+
+ReactorGroup::~ReactorGroup() {
+    stop();
+}
+
+void ReactorGroup::start() {
+    if (m_Started.exchange(true))
+        return;
+
+    m_Threads.reserve(m_Reactors.size());
+    for (size_t i = 0; i < m_Reactors.size(); ++i) {
+        Reactor* r = m_Reactors[i].get();
+        m_Threads.emplace_back([r, i]() {
+            ConnectionPool::bindThreadToShard(i);
+            r->run();
+        });
+    }
+    m_Logger.logInfo("Started " + std::to_string(m_Reactors.size()) + " reactor thread(s)");
+}
+
+void ReactorGroup::stop() {
+    if (!m_Started.exchange(false))
+        return;
+
+    for (auto& reactor : m_Reactors)
+        reactor->stop();
+
+    for (auto& t : m_Threads) {
+        if (t.joinable())
+            t.join();
+    }
+    m_Threads.clear();
+    for (auto& reactor : m_Reactors)
+        reactor->closeConnections();
+}
+
+Reactor& ReactorGroup::next() {
+    size_t index = m_NextIndex.fetch_add(1, std::memory_order_relaxed);
+    return *m_Reactors[index % m_Reactors.size()];
+}
+
+void ReactorGroup::setIdleTimeout(std::chrono::seconds timeout) {
+    for (auto& reactor : m_Reactors)
+        reactor->setIdleTimeout(timeout);
+}
+
+void ReactorGroup::setConnectTimeout(std::chrono::milliseconds timeout) {
+    for (auto& reactor : m_Reactors)
+        reactor->setConnectTimeout(timeout);
+}
+
+void ReactorGroup::enableStatsReport(std::chrono::milliseconds interval) {
+    for (auto& reactor : m_Reactors)
+        reactor->enableStatsReport(interval);
+}
+
+size_t ReactorGroup::resolveThreadCount(int configured) {
+    if (configured > 0)
+        return static_cast<size_t>(configured);
+    return availableCpus();
+}
+
+static long readCgroupCpuLimit() {
+    // cgroup v2: "<quota|max> <period>"
+    std::ifstream v2("/sys/fs/cgroup/cpu.max");
+    if (v2.is_open()) {
+        std::string quota;
+        long period = 0;
+        if (v2 >> quota >> period && quota != "max" && period > 0)
+            return static_cast<long>(std::ceil(std::stod(quota) / period));
+        return 0;
+    }
+
+    // cgroup v1: quota of -1 means unlimited
+    std::ifstream quotaFile("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+    std::ifstream periodFile("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+    long quota = -1;
+    long period = 0;
+    if (quotaFile >> quota && periodFile >> period && quota > 0 && period > 0)
+        return static_cast<long>(std::ceil(static_cast<double>(quota) / period));
+    return 0;
+}
+
+size_t ReactorGroup::availableCpus() {
+    long cpus = static_cast<long>(std::thread::hardware_concurrency());
+
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        cpus = CPU_COUNT(&set);
+#endif
+
+    long limit = readCgroupCpuLimit();
+    if (limit > 0)
+        cpus = std::min(cpus, limit);
+
+    return static_cast<size_t>(std::max(cpus, 1L));
+}
@@ -0,0 +1,94 @@
+#include "ring_buffer.h"
+#include <algorithm>
+#include <cstring>
+
+RingBuffer::RingBuffer(size_t capacity, bool ownStorage)
+    : m_Owned(ownStorage && capacity > 0 ? new char[capacity] : nullptr),
+      m_Data(m_Owned.get()),
+      m_Capacity(capacity) {}
+
+void RingBuffer::attach(char* storage) noexcept {
+    m_Data = storage;
+    clear();
+}
+
+char* RingBuffer::detach() noexcept {
+    clear();
+    if (m_Owned)
+        return nullptr;
+    char* storage = m_Data;
+    m_Data = nullptr;
+    return storage;
+}
+
+int RingBuffer::readableSpans(iovec (&spans)[2]) const noexcept {
+    if (m_Size == 0 || !m_Data)
+        return 0;
+    size_t first = std::min(m_Size, m_Capacity - m_Head);
+    spans[0].iov_base = m_Data + m_Head;
+    spans[0].iov_len = first;
+    if (first == m_Size)
+        return 1;
+    spans[1].iov_base = m_Data;
+    spans[1].iov_len = m_Size - first;
+    return 2;
+}
+
+int RingBuffer::writableSpans(iovec (&spans)[2]) noexcept {
+    if (m_Size == m_Capacity || !m_Data)
+        return 0;
+    size_t tail = (m_Head + m_Size) % m_Capacity;
+    size_t free = m_Capacity - m_Size;
+    size_t first = std::min(free, m_Capacity - tail);
+    spans[0].iov_base = m_Data + tail;
+    spans[0].iov_len = first;
+    if (first == free)
+        return 1;
+    spans[1].iov_base = m_Data;
+    spans[1].iov_len = free - first;
+    return 2;
+}
+
+void RingBuffer::commitWrite(size_t n) noexcept {
+    m_Size += std::min(n, available());
+}
+
+void RingBuffer::consume(size_t n) noexcept {
+    n = std::min(n, m_Size);
+    m_Size -= n;
+    // Rewind when drained so the next fill is one contiguous span.
+    m_Head = m_Size == 0 ? 0 : (m_Head + n) % m_Capacity;
+}
+
+size_t RingBuffer::write(const void* data, size_t len) noexcept {
+    iovec spans[2];
+    int count = writableSpans(spans);
+    const char* src = static_cast<const char*>(data);
+    size_t written = 0;
+    for (int i = 0; i < count && written < len; ++i) {
+        size_t n = std::min(spans[i].iov_len, len - written);
+        std::memcpy(spans[i].iov_base, src + written, n);
+        written += n;
+    }
+    commitWrite(written);
+    return written;
+}
+
+size_t RingBuffer::read(void* out, size_t len) noexcept {
+    iovec spans[2];
+    int count = readableSpans(spans);
+    char* dst = static_cast<char*>(out);
+    size_t copied = 0;
+    for (int i = 0; i < count && copied < len; ++i) {
+        size_t n = std::min(spans[i].iov_len, len - copied);
+        std::memcpy(dst + copied, spans[i].iov_base, n);
+        copied += n;
+    }
+    consume(copied);
+    return copied;
+}
+
+void RingBuffer::clear() noexcept {
+    m_Head = 0;
+    m_Size = 0;
+}
@@ -1,18 +1,162 @@
 #include "router.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+// Per-thread xorshift64*: selection must not share an RNG (or its lock) across reactors.
+static uint64_t nextRandom() {
+    thread_local uint64_t state = 0x9E3779B97F4A7C15ull ^ reinterpret_cast<uintptr_t>(&state);
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1Dull;
+}
+
+RoutingAlgorithm parseRoutingAlgorithm(const std::string& name) {
+    if (name == "roundRobin")
+        return RoutingAlgorithm::RoundRobin;
+    if (name == "leastConnections")
+        return RoutingAlgorithm::LeastConnections;
+    if (name == "powerOfTwoChoices")
+        return RoutingAlgorithm::PowerOfTwoChoices;
+    if (name == "consistentHash")
+        return RoutingAlgorithm::ConsistentHash;
+    throw std::invalid_argument("Unknown routing algorithm: " + name);
+}
+
+uint64_t clientAffinityKey(const sockaddr_in& client) {
+    // splitmix64's finalizer: consecutive addresses spread over the whole table.
+    uint64_t x = client.sin_addr.s_addr;
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
 
 Router::Router(BackendPool& backendPool, RoutingAlgorithm algorithm)
-    : m_BackendPool(backendPool), m_Algorithm(algorithm) {}
+    : m_BackendPool(backendPool), m_Algorithm(algorithm)
+{
+    if (m_Algorithm == RoutingAlgorithm::ConsistentHash && m_BackendPool.size() > 0) {
+        std::vector<std::string> names;
+        names.reserve(m_BackendPool.size());
+        for (BackendId id = 0; id < m_BackendPool.size(); ++id)
+            names.push_back(m_BackendPool.at(id).name);
+        m_Maglev = std::make_unique<MaglevTable>(names);
+    }
+}
 
-BackendConfig Router::selectBackend() {
+const Backend& Router::selectBackend(uint64_t clientKey) {
     switch (m_Algorithm) {
         case RoutingAlgorithm::RoundRobin:
             return m_BackendPool.getNextBackend();
         case RoutingAlgorithm::LeastConnections:
-            // Implement least connections logic
-            break;
+            return leastConnections();
         case RoutingAlgorithm::Random:
             // Implement random selection logic
             break;
+        case RoutingAlgorithm::PowerOfTwoChoices:
+            return powerOfTwoChoices();
+        case RoutingAlgorithm::ConsistentHash:
+            return consistentHash(clientKey);
     }
     throw std::runtime_error("Unknown routing algorithm");
 }
+
+// One relaxed load per backend, no locks. Each thread starts its scan one backend
+// further along, so ties (e.g. an idle fleet) spread out instead of all landing on
+// the first backend. Down and ejected backends are passed over unless none is healthy.
+const Backend& Router::leastConnections() {
+    size_t count = m_BackendPool.size();
+    if (count == 0)
+        throw std::runtime_error("No backends configured");
+    thread_local size_t rotation = 0;
+    size_t start = rotation++ % count;
+    bool anyHealthy = m_BackendPool.healthyCount() > 0;
+
+    size_t best = start;
+    uint32_t bestActive = UINT32_MAX;
+    for (size_t i = 0; i < count && bestActive > 0; ++i) {
+        size_t index = (start + i) % count;
+        auto id = static_cast<BackendId>(index);
+        if (anyHealthy && !m_BackendPool.isHealthy(id))
+            continue;
+        if (m_BackendPool.isEjected(id)) {
+            // Its ejection may be over, making this client its half-open trial.
+            if (m_BackendPool.admits(id))
+                return m_BackendPool.at(id);
+            continue;
+        }
+        uint32_t active = m_BackendPool.activeConnections(id);
+        if (active < bestActive) {
+            best = index;
+            bestActive = active;
+        }
+    }
+    return m_BackendPool.at(static_cast<BackendId>(best));
+}
+
+// O(1) whatever the fleet size: two loads of two cache lines. The second pick is drawn
+// from the other n - 1 backends, so the two are always distinct.
+const Backend& Router::powerOfTwoChoices() {
+    size_t count = m_BackendPool.size();
+    if (count == 0)
+        throw std::runtime_error("No backends configured");
+    if (count == 1)
+        return m_BackendPool.at(0);
+
+    uint64_t random = nextRandom();
+    auto first = static_cast<BackendId>(random % count);
+    auto second = static_cast<BackendId>((first + 1 + (random >> 32) % (count - 1)) % count);
+    for (BackendId id : {first, second}) {
+        // An ejected pick whose ejection is over takes this client as its half-open trial.
+        if (m_BackendPool.isEjected(id) && m_BackendPool.admits(id))
+            return m_BackendPool.at(id);
+    }
+    const Backend& a = m_BackendPool.at(first);
+    const Backend& b = m_BackendPool.at(second);
+    bool aUp = m_BackendPool.isHealthy(first) && !m_BackendPool.isEjected(first);
+    bool bUp = m_BackendPool.isHealthy(second) && !m_BackendPool.isEjected(second);
+    if (!aUp || !bUp) {
+        if (aUp || bUp)
+            return aUp ? a : b;
+        return leastConnections();   // both out: find any in rotation
+    }
+    auto now = BackendStats::Clock::now();
+    return b.stats->cost(now) < a.stats->cost(now) ? b : a;
+}
+
+// Side-effect free, unlike BackendPool::admits: O(backends) loads, no trial claimed.
+static bool anyInRotation(const BackendPool& pool) {
+    for (BackendId id = 0; id < pool.size(); ++id) {
+        if (pool.isHealthy(id) && !pool.isEjected(id))
+            return true;
+    }
+    return false;
+}
+
+// Slots per backend the walk visits when nothing is in rotation: it can only find a
+// half-open trial then, and giving up after a few rounds of owners bounds each accept.
+static constexpr uint64_t TRIAL_WALK_SLOTS_PER_BACKEND = 8;
+
+// A down or ejected backend's clients walk on to the next slots, whose owners are
+// effectively random: they spread over the survivors while every other client keeps
+// its backend.
+const Backend& Router::consistentHash(uint64_t clientKey) {
+    if (!m_Maglev)
+        throw std::runtime_error("No backends configured");
+    auto id = static_cast<BackendId>(m_Maglev->lookup(clientKey));
+    if (!m_BackendPool.admits(id) && m_BackendPool.healthyCount() > 0) {
+        // With a backend in rotation the walk reaches one of its slots in about
+        // size / survivors steps; without one, only a bounded search for a trial.
+        uint64_t limit = m_Maglev->size();
+        if (!anyInRotation(m_BackendPool))
+            limit = std::min<uint64_t>(limit, TRIAL_WALK_SLOTS_PER_BACKEND * m_BackendPool.size());
+        for (uint64_t step = 1; step < limit; ++step) {
+            auto next = static_cast<BackendId>(m_Maglev->lookup(clientKey + step));
+            if (m_BackendPool.admits(next))
+                return m_BackendPool.at(next);
+        }
+    }
+    return m_BackendPool.at(id);
+}
@@ -0,0 +1,145 @@
+#include "timer_wheel.h"
+#include <algorithm>
+
+TimerWheel::TimerWheel(std::chrono::milliseconds tick, size_t slots, Clock::time_point start)
+    : m_Tick(std::max(tick, std::chrono::milliseconds(1))),
+      m_Start(start),
+      m_Slots(std::max<size_t>(slots, 1), NIL) {}
+
+uint64_t TimerWheel::tickAt(Clock::time_point t) const {
+    if (t <= m_Start) return 0;
+    return static_cast<uint64_t>((t - m_Start) / m_Tick);
+}
+
+TimerId TimerWheel::schedule(std::chrono::milliseconds delay, Callback callback, Clock::time_point now) {
+    uint32_t index = allocateNode();
+    Node& node = m_Nodes[index];
+
+    // The deadline is measured from `now` and rounded up, so a timer never fires early;
+    // it is always at least one tick past m_CurrentTick, or its slot would only be
+    // visited a revolution later.
+    auto due = std::max(now, m_Start) + std::max(delay, std::chrono::milliseconds(0)) - m_Start;
+    uint64_t dueTick = static_cast<uint64_t>((due + m_Tick - Clock::duration(1)) / m_Tick);
+    node.expiresTick = std::max(dueTick, m_CurrentTick + 1);
+    node.callback = std::move(callback);
+    node.state = State::Scheduled;
+    link(index);
+    ++m_Active;
+    return makeId(index, node.generation);
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    uint32_t index = static_cast<uint32_t>(id & 0xffffffffu);
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+    if (id == INVALID_TIMER_ID || index >= m_Nodes.size())
+        return false;
+
+    Node& node = m_Nodes[index];
+    if (node.generation != generation || node.state == State::Free)
+        return false;
+
+    if (node.state == State::Scheduled)
+        unlink(index);
+    releaseNode(index);
+    --m_Active;
+    return true;
+}
+
+size_t TimerWheel::advance(Clock::time_point now) {
+    uint64_t target = tickAt(now);
+    size_t fired = 0;
+
+    while (m_CurrentTick < target) {
+        ++m_CurrentTick;
+        if (m_Active == 0) {
+            m_CurrentTick = target;
+            break;
+        }
+
+        uint32_t& head = m_Slots[m_CurrentTick % m_Slots.size()];
+        for (uint32_t index = head; index != NIL;) {
+            uint32_t next = m_Nodes[index].next;
+            if (m_Nodes[index].expiresTick <= m_CurrentTick) {
+                unlink(index);
+                m_Nodes[index].state = State::Firing;
+                m_Due.push_back(index);
+            }
+            index = next;
+        }
+
+        // Callbacks may schedule or cancel timers (including other due ones).
+        for (size_t i = 0; i < m_Due.size(); ++i) {
+            uint32_t index = m_Due[i];
+            Node& node = m_Nodes[index];
+            if (node.state != State::Firing)
+                continue;
+            Callback callback = std::move(node.callback);
+            releaseNode(index);
+            --m_Active;
+            ++fired;
+            callback();
+        }
+        m_Due.clear();
+    }
+    return fired;
+}
+
+int TimerWheel::nextTimeoutMs(int maxMs, Clock::time_point now) const {
+    if (m_Active == 0)
+        return maxMs;
+
+    uint64_t nowTick = tickAt(now);
+    uint64_t nextTick = nowTick + m_Slots.size();
+    for (uint64_t t = m_CurrentTick + 1; t <= m_CurrentTick + m_Slots.size(); ++t) {
+        if (m_Slots[t % m_Slots.size()] != NIL) {
+            nextTick = t;
+            break;
+        }
+    }
+
+    auto due = m_Start + m_Tick * static_cast<int64_t>(nextTick);
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(due - now).count();
+    int timeout = static_cast<int>(std::max<int64_t>(wait, 0));
+    return maxMs < 0 ? timeout : std::min(timeout, maxMs);
+}
+
+uint32_t TimerWheel::allocateNode() {
+    if (!m_FreeNodes.empty()) {
+        uint32_t index = m_FreeNodes.back();
+        m_FreeNodes.pop_back();
+        return index;
+    }
+    m_Nodes.emplace_back();
+    return static_cast<uint32_t>(m_Nodes.size() - 1);
+}
+
+void TimerWheel::releaseNode(uint32_t index) {
+    Node& node = m_Nodes[index];
+    node.callback = nullptr;
+    node.state = State::Free;
+    node.prev = node.next = NIL;
+    if (++node.generation == 0)
+        node.generation = 1;
+    m_FreeNodes.push_back(index);
+}
+
+void TimerWheel::link(uint32_t index) {
+    Node& node = m_Nodes[index];
+    uint32_t& head = m_Slots[node.expiresTick % m_Slots.size()];
+    node.prev = NIL;
+    node.next = head;
+    if (head != NIL)
+        m_Nodes[head].prev = index;
+    head = index;
+}
+
+void TimerWheel::unlink(uint32_t index) {
+    Node& node = m_Nodes[index];
+    if (node.prev != NIL)
+        m_Nodes[node.prev].next = node.next;
+    else
+        m_Slots[node.expiresTick % m_Slots.size()] = node.next;
+    if (node.next != NIL)
+        m_Nodes[node.next].prev = node.prev;
+    node.prev = node.next = NIL;
+}
@@ -11,6 +11,9 @@ public:
     MOCK_METHOD(int, wait, (std::vector<Event>& outEvents, int timeoutMs), (override));
     MOCK_METHOD(void, closeLoop, (), (override));
     MOCK_METHOD(void, updateFd, (int fd, bool wantRead, bool wantWrite), (override));
+    MOCK_METHOD(TimerId, addTimer, (std::chrono::milliseconds delay, TimerCallback callback), (override));
+    MOCK_METHOD(bool, cancelTimer, (TimerId id), (override));
+    MOCK_METHOD(size_t, runTimers, (), (override));
 };
 
 class MockConnection : public IConnection {
@@ -19,15 +22,20 @@ public:
     MOCK_METHOD(void, onWritable, (int fd), (override));
     MOCK_METHOD(bool, isConnected, (), (const, override));
     MOCK_METHOD(void, setConnected, (bool connected), (override));
+    MOCK_METHOD(void, noteBackendFailure, (), (override));
     MOCK_METHOD(int, getBackendFd, (), (const, override));
     MOCK_METHOD(int, getClientFd, (), (const, override));
     MOCK_METHOD(bool, hasBackendOpen, (), (const, override));
     MOCK_METHOD(bool, isClientFd, (int fd), (const, override));
     MOCK_METHOD(bool, connectToBackend, (), (override));
+    MOCK_METHOD(void, adoptBackendFd, (int fd), (override));
     MOCK_METHOD(void, closeAll, (), (override));
-    MOCK_METHOD(const BackendConfig&, getBackendConfig, (), (const, override));
+    MOCK_METHOD(const Backend&, getBackend, (), (const, override));
     MOCK_METHOD(bool, isIdleFor, (std::chrono::seconds duration), (const, override));
+    MOCK_METHOD(std::chrono::steady_clock::time_point, getLastActivity, (), (const, override));
     MOCK_METHOD(void, onClose, (int fd), (override));
+    MOCK_METHOD(void, attachEventLoop, (IEventLoop* loop), (override));
+    MOCK_METHOD(size_t, stateBytes, (), (const, override));
 private:
     bool m_Closed = false;
  
@@ -38,4 +46,5 @@ public:
     MOCK_METHOD(void, logInfo, (const std::string& msg), ());
     MOCK_METHOD(void, logError, (const std::string& msg), ());
     MOCK_METHOD(void, logDebug, (const std::string& msg), ());
+    MOCK_METHOD(void, logWarn, (const std::string& msg), ());
 };
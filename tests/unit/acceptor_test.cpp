@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <thread>
 #include <arpa/inet.h>
+#include <sys/resource.h>
+#include <unistd.h>
 #include "acceptor.h"
 #include "backend_pool.h"
 #include "router.h"
@@ -14,14 +16,41 @@ public:
     explicit MockRouter(BackendPool& pool)
         : Router(pool, RoutingAlgorithm::RoundRobin) {}
 
-    BackendConfig selectBackend() override {
+    const Backend& selectBackend(uint64_t) override {
         called = true;
-        return {"127.0.0.1", 9001};
+        return backend;
     }
 
+    Backend backend = Backend::resolve({"127.0.0.1", 9001}, 0);
     bool called = false;
 };
 
+// Records timers instead of running a loop; the test fires them by hand.
+class TimerOnlyLoop : public IEventLoop {
+public:
+    bool registerFd(int, bool, bool) override { return true; }
+    bool unregisterFd(int) override { return true; }
+    int wait(std::vector<Event>& events, int) override { events.clear(); return 0; }
+    void closeLoop() override {}
+    void updateFd(int, bool, bool) override {}
+    TimerId addTimer(std::chrono::milliseconds, TimerCallback callback) override {
+        timers.push_back(std::move(callback));
+        return timers.size();
+    }
+    bool cancelTimer(TimerId) override { return true; }
+    size_t runTimers() override { return 0; }
+
+    std::vector<TimerCallback> timers;
+};
+
+// Listeners bind port 0 so parallel test binaries never collide; this reads it back.
+static uint16_t boundPort(int fd) {
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    return ntohs(addr.sin_port);
+}
+
 
 TEST(AcceptorTest, ThrowsIfBindFails) {
     ListenConfig cfg{"127.0.0.1", 80, 10}; 
@@ -38,7 +67,7 @@ TEST(AcceptorTest, ThrowsIfBindFails) {
 }
 
 TEST(AcceptorTest, AcceptsAndCallsCallback) {
-    ListenConfig cfg{"127.0.0.1", 9099, 10};
+    ListenConfig cfg{"127.0.0.1", 0, 10};
     vector<BackendConfig> backends = {{"127.0.0.1", 9001}};
     BackendPool pool(backends);
     MockRouter router(pool);
@@ -54,6 +83,7 @@ TEST(AcceptorTest, AcceptsAndCallsCallback) {
     };
     
     Acceptor acceptor(cfg, router, logger, connectionPool, onAccept);
+    cfg.port = boundPort(acceptor.getListenFd());
     acceptor.start();
 
     int clientFd = socket(AF_INET, SOCK_STREAM, 0);
@@ -72,7 +102,7 @@ TEST(AcceptorTest, AcceptsAndCallsCallback) {
 }
 
 TEST(AcceptorTest, StopCleansUpProperly) {
-    ListenConfig cfg{"127.0.0.1", 9100, 10};
+    ListenConfig cfg{"127.0.0.1", 0, 10};
     vector<BackendConfig> backends = {{"127.0.0.1", 9001}};
     BackendPool pool(backends);
     MockRouter router(pool);
@@ -93,7 +123,7 @@ TEST(AcceptorTest, StopCleansUpProperly) {
 }
 
 TEST(AcceptorTest, StartStopMultipleTimesIsSafe) {
-    ListenConfig cfg{"127.0.0.1", 9110, 10};
+    ListenConfig cfg{"127.0.0.1", 0, 10};
     vector<BackendConfig> backends = {{"127.0.0.1", 9001}};
     BackendPool pool(backends);
     MockRouter router(pool);
@@ -137,7 +167,7 @@ TEST(AcceptorTest, InvalidHostThrows) {
 }
 
 TEST(AcceptorTest, HandlesMultipleClients) {
-    ListenConfig cfg{"127.0.0.1", 9300, 10};
+    ListenConfig cfg{"127.0.0.1", 0, 10};
     vector<BackendConfig> backends = {{"127.0.0.1", 9001}};
     BackendPool pool(backends);
     MockRouter router(pool);
@@ -151,6 +181,7 @@ TEST(AcceptorTest, HandlesMultipleClients) {
     };
 
     Acceptor acceptor(cfg, router, logger, connectionPool, onAccept);
+    cfg.port = boundPort(acceptor.getListenFd());
     acceptor.start();
 
     for (int i = 0; i < 5; ++i) {
@@ -173,12 +204,12 @@ TEST(AcceptorTest, BindToUsedPortThrows) {
     int serverFd = socket(AF_INET, SOCK_STREAM, 0);
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
-    addr.sin_port = htons(9400);
+    addr.sin_port = 0;
     addr.sin_addr.s_addr = inet_addr("127.0.0.1");
     ASSERT_EQ(::bind(serverFd, (sockaddr*)&addr, sizeof(addr)), 0);
     ASSERT_EQ(::listen(serverFd, 1), 0);
 
-    ListenConfig cfg{"127.0.0.1", 9400, 10};
+    ListenConfig cfg{"127.0.0.1", boundPort(serverFd), 10};
     vector<BackendConfig> backends = {{"127.0.0.1", 9001}};
     BackendPool pool(backends);
     MockRouter router(pool);
@@ -195,7 +226,7 @@ TEST(AcceptorTest, BindToUsedPortThrows) {
 }
 
 TEST(AcceptorTest, ClientDisconnectTriggersCleanup) {
-    ListenConfig cfg{"127.0.0.1", 9500, 10};
+    ListenConfig cfg{"127.0.0.1", 0, 10};
     vector<BackendConfig> backends = {{"127.0.0.1", 9001}};
     BackendPool pool(backends);
     MockRouter router(pool);
@@ -209,6 +240,7 @@ TEST(AcceptorTest, ClientDisconnectTriggersCleanup) {
     };
 
     Acceptor acceptor(cfg, router, logger, connectionPool, onAccept);
+    cfg.port = boundPort(acceptor.getListenFd());
     acceptor.start();
 
     int clientFd = socket(AF_INET, SOCK_STREAM, 0);
@@ -226,7 +258,7 @@ TEST(AcceptorTest, ClientDisconnectTriggersCleanup) {
 }
 
 TEST(AcceptorTest, LoggerLogsStartup) {
-    ListenConfig cfg{"127.0.0.1", 9600, 10};
+    ListenConfig cfg{"127.0.0.1", 0, 10};
     vector<BackendConfig> backends = {{"127.0.0.1", 9001}};
     BackendPool pool(backends);
     MockRouter router(pool);
@@ -243,3 +275,113 @@ TEST(AcceptorTest, LoggerLogsStartup) {
     SUCCEED(); 
 }
 
+
+TEST(AcceptorTest, ReusePortAllowsOneListenerPerWorker) {
+    ListenConfig cfg{"127.0.0.1", 0, 10, true};
+    vector<BackendConfig> backends = {{"127.0.0.1", 9001}};
+    BackendPool pool(backends);
+    MockRouter router(pool);
+    Logger logger;
+    ConnectionPool connectionPool;
+
+    auto onAccept = [](std::shared_ptr<IConnection>, int, const BackendConfig&) {};
+
+    Acceptor first(cfg, router, logger, connectionPool, onAccept);
+    cfg.port = boundPort(first.getListenFd());
+    EXPECT_NO_THROW({
+        Acceptor second(cfg, router, logger, connectionPool, onAccept);
+        EXPECT_NE(first.getListenFd(), second.getListenFd());
+    });
+}
+
+TEST(AcceptorTest, AcceptPendingDrainsBacklogWithoutThread) {
+    ListenConfig cfg{"127.0.0.1", 0, 10, true};
+    vector<BackendConfig> backends = {{"127.0.0.1", 9001}};
+    BackendPool pool(backends);
+    MockRouter router(pool);
+    Logger logger;
+    ConnectionPool connectionPool;
+
+    int callbackCount = 0;
+    auto onAccept = [&](std::shared_ptr<IConnection> conn, int, const BackendConfig&) {
+        callbackCount++;
+        conn->closeAll();
+    };
+
+    Acceptor acceptor(cfg, router, logger, connectionPool, onAccept);
+    cfg.port = boundPort(acceptor.getListenFd());
+
+    std::vector<int> clients;
+    for (int i = 0; i < 3; ++i) {
+        int clientFd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(cfg.port);
+        addr.sin_addr.s_addr = inet_addr(cfg.host.c_str());
+        ASSERT_EQ(connect(clientFd, (struct sockaddr*)&addr, sizeof(addr)), 0);
+        clients.push_back(clientFd);
+    }
+
+    EXPECT_EQ(acceptor.acceptPending(), 3);
+    EXPECT_EQ(callbackCount, 3);
+    EXPECT_EQ(acceptor.acceptPending(), 0);
+
+    for (int fd : clients)
+        close(fd);
+}
+
+TEST(AcceptorTest, RetriesOnTimerWhenOutOfFds) {
+    ListenConfig cfg{"127.0.0.1", 0, 10, true};
+    vector<BackendConfig> backends = {{"127.0.0.1", 9001}};
+    BackendPool pool(backends);
+    MockRouter router(pool);
+    Logger logger;
+    ConnectionPool connectionPool;
+    TimerOnlyLoop loop;
+
+    int callbackCount = 0;
+    auto onAccept = [&](std::shared_ptr<IConnection> conn, int, const BackendConfig&) {
+        callbackCount++;
+        conn->closeAll();
+    };
+
+    Acceptor acceptor(cfg, router, logger, connectionPool, onAccept);
+    acceptor.attachEventLoop(&loop);
+    cfg.port = boundPort(acceptor.getListenFd());
+
+    std::vector<int> clients;
+    for (int i = 0; i < 2; ++i) {
+        int clientFd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(cfg.port);
+        addr.sin_addr.s_addr = inet_addr(cfg.host.c_str());
+        ASSERT_EQ(connect(clientFd, (struct sockaddr*)&addr, sizeof(addr)), 0);
+        clients.push_back(clientFd);
+    }
+
+    // Cap the fd table at the next free number so accept() fails with EMFILE.
+    rlimit saved{};
+    ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &saved), 0);
+    int nextFd = dup(0);
+    ASSERT_GE(nextFd, 0);
+    close(nextFd);
+    rlimit capped = saved;
+    capped.rlim_cur = static_cast<rlim_t>(nextFd);
+    ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &capped), 0);
+
+    int accepted = acceptor.acceptPending();
+    ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &saved), 0);
+    EXPECT_EQ(accepted, 0);
+    ASSERT_EQ(loop.timers.size(), 1u);
+
+    // No new client arrives to re-trigger the listener: the retry drains the backlog.
+    auto retry = std::move(loop.timers[0]);
+    loop.timers.clear();
+    retry();
+    EXPECT_EQ(callbackCount, 2);
+    EXPECT_TRUE(loop.timers.empty());
+
+    for (int fd : clients)
+        close(fd);
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include "backend_pool.h"
+#include <arpa/inet.h>
+#include <map>
+#include <set>
 
 using namespace std;
 
@@ -59,3 +62,262 @@ TEST_F(BackendPoolTest, HandlesSingleBackend) {
         EXPECT_EQ(b.port, 9001);
     }
 }
+
+TEST_F(BackendPoolTest, InternsBackendsWithResolvedAddresses) {
+    BackendPool pool(backends);
+    ASSERT_EQ(pool.size(), 3u);
+
+    for (BackendId id = 0; id < pool.size(); ++id) {
+        const Backend& backend = pool.at(id);
+        EXPECT_EQ(backend.id, id);
+        EXPECT_EQ(backend.name, backends[id].host + ":" + to_string(backends[id].port));
+        ASSERT_TRUE(backend.isResolved());
+        const auto* addr = reinterpret_cast<const sockaddr_in*>(&backend.addr);
+        EXPECT_EQ(addr->sin_family, AF_INET);
+        EXPECT_EQ(ntohs(addr->sin_port), backends[id].port);
+    }
+
+    // Selection hands out the interned entries themselves, never copies.
+    EXPECT_EQ(&pool.getNextBackend(), &pool.at(0));
+}
+
+TEST_F(BackendPoolTest, WeightedPicksAreInterleaved) {
+    backends[0].weight = 5;
+    BackendPool pool(backends);
+
+    vector<uint16_t> ports;
+    for (int i = 0; i < 7; ++i)
+        ports.push_back(pool.getNextBackend().port);
+    EXPECT_EQ(ports, (vector<uint16_t>{9001, 9001, 9002, 9001, 9003, 9001, 9001}));
+    EXPECT_EQ(pool.getNextBackend().port, 9001);   // next period
+}
+
+TEST_F(BackendPoolTest, WeightedPicksFollowWeightRatios) {
+    backends[0].weight = 30;
+    backends[1].weight = 20;
+    backends[2].weight = 10;
+    BackendPool pool(backends);
+
+    map<BackendId, int> picks;
+    for (int i = 0; i < 600; ++i)
+        ++picks[pool.getNextBackend().id];
+    EXPECT_EQ(picks[0], 300);
+    EXPECT_EQ(picks[1], 200);
+    EXPECT_EQ(picks[2], 100);
+}
+
+TEST_F(BackendPoolTest, HugeWeightsStillGiveEveryBackendATurn) {
+    backends[0].weight = UINT32_MAX;
+    BackendPool pool(backends);
+
+    set<BackendId> seen;
+    for (int i = 0; i < (1 << 17) && seen.size() < 3; ++i)
+        seen.insert(pool.getNextBackend().id);
+    EXPECT_EQ(seen.size(), 3u);
+}
+
+TEST_F(BackendPoolTest, RoundRobinSkipsDownBackends) {
+    BackendPool pool(backends);
+    EXPECT_EQ(pool.healthyCount(), 3u);
+    pool.setHealthy(1, false);
+    pool.setHealthy(1, false);   // idempotent
+    EXPECT_FALSE(pool.isHealthy(1));
+    EXPECT_EQ(pool.healthyCount(), 2u);
+
+    for (int i = 0; i < 6; ++i)
+        EXPECT_NE(pool.getNextBackend().id, 1u);
+
+    pool.setHealthy(1, true);
+    set<BackendId> seen;
+    for (int i = 0; i < 3; ++i)
+        seen.insert(pool.getNextBackend().id);
+    EXPECT_EQ(seen.size(), 3u);
+}
+
+TEST_F(BackendPoolTest, DownBackendTurnsAreSharedOut) {
+    BackendPool pool(backends);
+    pool.setHealthy(1, false);
+    map<BackendId, int> picks;
+    for (int i = 0; i < 3000; ++i)
+        ++picks[pool.getNextBackend().id];
+    EXPECT_EQ(picks.count(1), 0u);
+    EXPECT_GT(picks[0], 1300);
+    EXPECT_GT(picks[2], 1300);
+}
+
+TEST_F(BackendPoolTest, FailsOpenWhenEveryBackendIsDown) {
+    BackendPool pool(backends);
+    for (BackendId id = 0; id < pool.size(); ++id)
+        pool.setHealthy(id, false);
+    EXPECT_EQ(pool.healthyCount(), 0u);
+    EXPECT_EQ(pool.getNextBackend().id, 0u);
+    EXPECT_EQ(pool.getNextBackend().id, 1u);
+}
+
+TEST(BackendPoolHealthTest, TracksBackendsBeyondOneBitmapWord) {
+    vector<BackendConfig> many;
+    for (uint16_t i = 0; i < 130; ++i)
+        many.push_back({"127.0.0.1", static_cast<uint16_t>(10000 + i)});
+    BackendPool pool(many);
+    EXPECT_EQ(pool.healthyCount(), 130u);
+    EXPECT_TRUE(pool.isHealthy(129));
+
+    pool.setHealthy(64, false);
+    pool.setHealthy(129, false);
+    EXPECT_TRUE(pool.isHealthy(63));
+    EXPECT_FALSE(pool.isHealthy(64));
+    EXPECT_FALSE(pool.isHealthy(129));
+    EXPECT_EQ(pool.healthyCount(), 128u);
+}
+
+TEST(BackendTest, UnresolvableHostIsMarkedUnresolved) {
+    Backend backend = Backend::resolve({"256.256.256.256", 80}, 7);
+    EXPECT_EQ(backend.id, 7u);
+    EXPECT_FALSE(backend.isResolved());
+}
+
+TEST(BackendStatsTest, PeakEwmaJumpsToSpikesAndDecaysGradually) {
+    using namespace std::chrono;
+    BackendStats stats;
+    auto t0 = BackendStats::Clock::now();
+
+    stats.observeLatency(milliseconds(1), t0);
+    EXPECT_EQ(stats.latencyNanos.load(), 1000000u);
+    stats.observeLatency(milliseconds(10), t0 + seconds(1));
+    EXPECT_EQ(stats.latencyNanos.load(), 10000000u);
+
+    // A fast sample a second later only pulls the estimate down a little.
+    stats.observeLatency(milliseconds(1), t0 + seconds(2));
+    EXPECT_GT(stats.latencyNanos.load(), 8000000u);
+    EXPECT_LT(stats.latencyNanos.load(), 10000000u);
+}
+
+TEST(BackendStatsTest, CostScalesWithLoadAndFadesWhenQuiet) {
+    using namespace std::chrono;
+    BackendStats stats;
+    auto t0 = BackendStats::Clock::now();
+    stats.observeLatency(milliseconds(5), t0);
+
+    double idle = stats.cost(t0);
+    stats.active = 3;
+    EXPECT_DOUBLE_EQ(stats.cost(t0), idle * 4);
+    EXPECT_LT(stats.cost(t0 + seconds(60)), stats.cost(t0) / 100);
+}
+
+class CircuitTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        policy.consecutiveFailures = 3;
+        policy.baseEjectionMs = 1000;
+        policy.maxEjectionMs = 3000;
+        stats.outlierPolicy = &policy;
+    }
+
+    OutlierDetectionConfig policy;
+    BackendStats stats;
+    BackendStats::Clock::time_point t0 = BackendStats::Clock::now();
+};
+
+TEST_F(CircuitTest, EjectsAfterConsecutiveFailuresOnly) {
+    using namespace std::chrono;
+    stats.recordFailure(t0);
+    stats.recordFailure(t0);
+    stats.recordSuccess();   // breaks the streak
+    stats.recordFailure(t0);
+    stats.recordFailure(t0);
+    EXPECT_EQ(stats.circuitState(), BackendStats::Circuit::Closed);
+    EXPECT_TRUE(stats.admits());
+
+    EXPECT_EQ(stats.recordFailure(t0), milliseconds(1000));
+    EXPECT_EQ(stats.circuitState(), BackendStats::Circuit::Open);
+    EXPECT_FALSE(stats.admits());
+    // Late failures from connections opened before the ejection do not extend it.
+    EXPECT_EQ(stats.recordFailure(t0), BackendStats::Clock::duration::zero());
+}
+
+TEST_F(CircuitTest, HalfOpenTrialDecidesAndEjectionsDouble) {
+    using namespace std::chrono;
+    for (int i = 0; i < 3; ++i)
+        stats.recordFailure(t0);
+    ASSERT_EQ(stats.circuitState(), BackendStats::Circuit::Open);
+
+    // Past the ejection (admits() reads the real clock, so rewind the deadline instead).
+    stats.circuit = uint64_t(1);
+    EXPECT_TRUE(stats.admits());
+    EXPECT_EQ(stats.circuitState(), BackendStats::Circuit::HalfOpen);
+    EXPECT_FALSE(stats.admits());   // one trial at a time
+
+    // The trial fails: open again, for twice as long, then capped at the maximum.
+    EXPECT_EQ(stats.recordFailure(t0), milliseconds(2000));
+    stats.circuit = uint64_t(1);
+    ASSERT_TRUE(stats.admits());
+    EXPECT_EQ(stats.recordFailure(t0), milliseconds(3000));
+
+    stats.circuit = uint64_t(1);
+    ASSERT_TRUE(stats.admits());
+    stats.recordSuccess();
+    EXPECT_EQ(stats.circuitState(), BackendStats::Circuit::Closed);
+    EXPECT_TRUE(stats.admits());
+}
+
+TEST_F(CircuitTest, LongCleanRunResetsEjectionLength) {
+    using namespace std::chrono;
+    for (int i = 0; i < 3; ++i)
+        stats.recordFailure(t0);
+    stats.circuit = uint64_t(1);
+    ASSERT_TRUE(stats.admits());
+    stats.recordSuccess();
+
+    auto later = BackendStats::Clock::now() + seconds(4);
+    for (int i = 0; i < 2; ++i)
+        stats.recordFailure(later);
+    EXPECT_EQ(stats.recordFailure(later), milliseconds(1000));
+}
+
+TEST_F(CircuitTest, DisabledWithoutPolicy) {
+    stats.outlierPolicy = nullptr;
+    for (int i = 0; i < 10; ++i)
+        EXPECT_EQ(stats.recordFailure(t0), BackendStats::Clock::duration::zero());
+    EXPECT_EQ(stats.circuitState(), BackendStats::Circuit::Closed);
+}
+
+TEST_F(BackendPoolTest, RoundRobinSkipsEjectedBackends) {
+    OutlierDetectionConfig policy;
+    policy.consecutiveFailures = 1;
+    BackendPool pool(backends);
+    pool.enableOutlierDetection(policy);
+
+    pool.at(2).stats->recordFailure();
+    EXPECT_TRUE(pool.isEjected(2));
+    for (int i = 0; i < 6; ++i)
+        EXPECT_NE(pool.getNextBackend().id, 2u);
+
+    // Once the ejection runs out the next pick that lands on it is the trial.
+    pool.at(2).stats->circuit = uint64_t(1);
+    set<BackendId> seen;
+    for (int i = 0; i < 3; ++i)
+        seen.insert(pool.getNextBackend().id);
+    EXPECT_TRUE(seen.count(2));
+    EXPECT_EQ(pool.at(2).stats->circuitState(), BackendStats::Circuit::HalfOpen);
+}
+
+TEST_F(BackendPoolTest, EjectionCapKeepsBackendsInRotation) {
+    OutlierDetectionConfig policy;
+    policy.consecutiveFailures = 1;
+    policy.maxEjectionPercent = 50;   // one of three
+    BackendPool pool(backends);
+    pool.enableOutlierDetection(policy);
+
+    pool.at(0).stats->recordFailure();
+    pool.at(1).stats->recordFailure();
+    EXPECT_TRUE(pool.isEjected(0));
+    EXPECT_FALSE(pool.isEjected(1));
+
+    // Reinstating backend 0 frees its slot for the next failing backend.
+    pool.at(0).stats->circuit = uint64_t(1);
+    ASSERT_TRUE(pool.admits(0));
+    pool.at(0).stats->recordSuccess();
+    pool.at(1).stats->recordFailure();
+    EXPECT_FALSE(pool.isEjected(0));
+    EXPECT_TRUE(pool.isEjected(1));
+}
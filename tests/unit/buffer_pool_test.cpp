@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include "buffer_pool.h"
+#include <set>
+#include <thread>
+#include <vector>
+
+TEST(BufferPoolTest, BudgetBoundsChunksInUse) {
+    BufferPool pool(4096, 4 * 4096);
+    EXPECT_EQ(pool.capacity(), 4u);
+
+    std::vector<char*> chunks;
+    for (int i = 0; i < 4; ++i) {
+        char* chunk = pool.acquire();
+        ASSERT_NE(chunk, nullptr);
+        chunk[0] = 'x';
+        chunk[4095] = 'y';
+        chunks.push_back(chunk);
+    }
+    EXPECT_EQ(pool.acquire(), nullptr);
+    EXPECT_EQ(pool.bytesInUse(), 4u * 4096);
+
+    pool.release(chunks.back());
+    EXPECT_EQ(pool.acquire(), chunks.back());
+}
+
+TEST(BufferPoolTest, FallsBackWhenHugePagesUnavailable) {
+    // Works whether or not hugetlbfs pages are reserved on this machine.
+    BufferPool pool(65536, 4 * 1024 * 1024, true);
+    char* chunk = pool.acquire();
+    ASSERT_NE(chunk, nullptr);
+    chunk[65535] = 1;
+    pool.release(chunk);
+    EXPECT_EQ(pool.inUse(), 0u);
+}
+
+TEST(BufferPoolTest, ConcurrentAcquireReleaseNeverDoubleHandsOut) {
+    BufferPool pool(256, 64 * 256);
+    std::atomic<bool> duplicate{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&pool, &duplicate, t]() {
+            for (int i = 0; i < 20000; ++i) {
+                char* chunk = pool.acquire();
+                if (!chunk)
+                    continue;
+                chunk[0] = static_cast<char>(t);
+                std::this_thread::yield();
+                if (chunk[0] != static_cast<char>(t))
+                    duplicate = true;
+                pool.release(chunk);
+            }
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+    EXPECT_FALSE(duplicate);
+    EXPECT_EQ(pool.inUse(), 0u);
+}
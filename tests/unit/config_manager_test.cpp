@@ -20,7 +20,7 @@ TEST(ConfigManagerTest, LoadValidConfig) {
         "listen": { "host": "0.0.0.0", "port": 8080 },
         "backends": [
             { "host": "127.0.0.1", "port": 9001 },
-            { "host": "127.0.0.1", "port": 9002 }
+            { "host": "127.0.0.1", "port": 9002, "weight": 3 }
         ],
         "logging": { "level": "info", "mode": "stdout" },
         "reactor": {
@@ -45,6 +45,8 @@ TEST(ConfigManagerTest, LoadValidConfig) {
     EXPECT_EQ(cfg.backends[0].port, 9001);
     EXPECT_EQ(cfg.backends[1].host, "127.0.0.1");
     EXPECT_EQ(cfg.backends[1].port, 9002);
+    EXPECT_EQ(cfg.backends[0].weight, 1u);
+    EXPECT_EQ(cfg.backends[1].weight, 3u);
 
     EXPECT_EQ(cfg.logging.level, "info");
     EXPECT_EQ(cfg.logging.mode, "stdout");
@@ -162,6 +164,84 @@ TEST(ConfigValidationTest, ThrowsIfBackendPortInvalid) {
     }, runtime_error);
 }
 
+TEST(ConfigValidationTest, ThrowsIfBackendWeightNotPositive) {
+    string jsonContent = R"({
+        "listen": { "host": "0.0.0.0", "port": 8080 },
+        "backends": [{ "host": "127.0.0.1", "port": 9001, "weight": 0 }],
+        "logging": { "level": "info", "mode": "stdout" },
+        "reactor": { "threads": 2 },
+        "shutdown": { "drainSeconds": 5 }
+    })";
+    string path = "temp_invalid_backend_weight.json";
+    writeConfigFile(path, jsonContent);
+    ConfigManager manager(path);
+    EXPECT_THROW({
+        manager.getConfig();
+    }, runtime_error);
+}
+
+TEST(ConfigValidationTest, ThrowsIfHealthCheckThresholdNotPositive) {
+    string jsonContent = R"({
+        "listen": { "host": "0.0.0.0", "port": 8080 },
+        "backends": [{ "host": "127.0.0.1", "port": 9001 }],
+        "logging": { "level": "info", "mode": "stdout" },
+        "healthCheck": { "enabled": true, "unhealthyThreshold": 0 },
+        "shutdown": { "drainSeconds": 5 }
+    })";
+    string path = "temp_invalid_health_check.json";
+    writeConfigFile(path, jsonContent);
+    ConfigManager manager(path);
+    EXPECT_THROW({
+        manager.getConfig();
+    }, runtime_error);
+}
+
+TEST(ConfigValidationTest, ThrowsIfMaxEjectionPercentOutOfRange) {
+    string jsonContent = R"({
+        "listen": { "host": "0.0.0.0", "port": 8080 },
+        "backends": [{ "host": "127.0.0.1", "port": 9001 }],
+        "logging": { "level": "info", "mode": "stdout" },
+        "outlierDetection": { "enabled": true, "maxEjectionPercent": 0 },
+        "shutdown": { "drainSeconds": 5 }
+    })";
+    string path = "temp_invalid_ejection_percent.json";
+    writeConfigFile(path, jsonContent);
+    ConfigManager manager(path);
+    EXPECT_THROW({
+        manager.getConfig();
+    }, runtime_error);
+}
+
+TEST(ConfigValidationTest, DefaultMaxIdleFollowsSmallConnectionCap) {
+    string jsonContent = R"({
+        "listen": { "host": "0.0.0.0", "port": 8080 },
+        "backends": [{ "host": "127.0.0.1", "port": 9001 }],
+        "logging": { "level": "info", "mode": "stdout" },
+        "connectionPool": { "maxConnectionsPerBackend": 2 },
+        "shutdown": { "drainSeconds": 5 }
+    })";
+    string path = "temp_small_pool_cap.json";
+    writeConfigFile(path, jsonContent);
+    ConfigManager manager(path);
+    EXPECT_EQ(manager.getConfig().connectionPool.maxIdle, 2u);
+}
+
+TEST(ConfigValidationTest, ThrowsIfExplicitMaxIdleExceedsConnectionCap) {
+    string jsonContent = R"({
+        "listen": { "host": "0.0.0.0", "port": 8080 },
+        "backends": [{ "host": "127.0.0.1", "port": 9001 }],
+        "logging": { "level": "info", "mode": "stdout" },
+        "connectionPool": { "maxConnectionsPerBackend": 2, "maxIdle": 3 },
+        "shutdown": { "drainSeconds": 5 }
+    })";
+    string path = "temp_invalid_max_idle.json";
+    writeConfigFile(path, jsonContent);
+    ConfigManager manager(path);
+    EXPECT_THROW({
+        manager.getConfig();
+    }, runtime_error);
+}
+
 TEST(ConfigValidationTest, ThrowsIfLoggingLevelInvalid) {
     string jsonContent = R"({
         "listen": { "host": "0.0.0.0", "port": 8080 },
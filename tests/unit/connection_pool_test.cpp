@@ -3,27 +3,39 @@
 #include <unistd.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
+#include <sys/resource.h>
+#include <poll.h>
 #include <thread>
 #include <vector>
-// Helper to simulate backend
-static BackendConfig makeBackend(const std::string& host, int port) {
-    BackendConfig cfg;
-    cfg.host = host;
-    cfg.port = port;
-    return cfg;
+// Helper to simulate backend; every test backend gets its own interned ID.
+static Backend makeBackend(const std::string& host, int port) {
+    static BackendId nextId = 0;
+    return Backend::resolve({host, static_cast<uint16_t>(port)}, nextId++ % ConnectionPool::DEFAULT_MAX_BACKENDS);
 }
-static void createDummyServer(int port) {
+static uint16_t boundPort(int fd) {
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    return ntohs(addr.sin_port);
+}
+// Listens on a free port (bound as 0, so parallel test binaries never collide) and
+// accepts one connection; returns the port, or 0 on failure.
+static uint16_t createDummyServer() {
     int serverFd = socket(AF_INET, SOCK_STREAM, 0);
     int opt = 1;
     setsockopt(serverFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
 
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
+    addr.sin_port = 0;
     addr.sin_addr.s_addr = inet_addr("127.0.0.1");
 
-    ASSERT_EQ(::bind(serverFd, (struct sockaddr*)&addr, sizeof(addr)), 0);
-    ASSERT_EQ(::listen(serverFd, 1), 0);
+    if (::bind(serverFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(serverFd, 1) != 0) {
+        ADD_FAILURE() << "dummy server could not listen";
+        close(serverFd);
+        return 0;
+    }
+    uint16_t port = boundPort(serverFd);
 
     std::thread([serverFd]() {
         sockaddr_in clientAddr{};
@@ -35,6 +47,7 @@ static void createDummyServer(int port) {
         }
         close(serverFd);
     }).detach();
+    return port;
 }
 
 
@@ -55,11 +68,12 @@ TEST(ConnectionPoolTest, AcquireConnection) {
 
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
-    addr.sin_port = htons(9100);
+    addr.sin_port = 0;
     addr.sin_addr.s_addr = inet_addr("127.0.0.1");
 
     ASSERT_EQ(::bind(serverFd, (struct sockaddr*)&addr, sizeof(addr)), 0);
     ASSERT_EQ(::listen(serverFd, 1), 0);
+    uint16_t port = boundPort(serverFd);
 
     pid_t pid = fork();
     ASSERT_GE(pid, 0);
@@ -75,9 +89,10 @@ TEST(ConnectionPoolTest, AcquireConnection) {
         close(serverFd);
         _exit(0);
     }
+    close(serverFd);   // the child owns the listener now
     std::this_thread::sleep_for(std::chrono::milliseconds(50));
     ConnectionPool pool;
-    auto backend = makeBackend("127.0.0.1", 9100);
+    auto backend = makeBackend("127.0.0.1", port);
 
     int fd = pool.addNewConnection(backend);
     ASSERT_GE(fd, 0);
@@ -92,24 +107,14 @@ TEST(ConnectionPoolTest, AcquireConnection) {
 
 
 TEST(ConnectionPoolTest, PoolDeletesOldestWhenFull) {
-    pid_t pid = fork();
-    if (pid == 0) {
-        for (int p = 9200; p <= 9211; ++p)
-            createDummyServer(p);
-        std::this_thread::sleep_for(std::chrono::seconds(3));
-        _exit(0);
-    }
-
-    std::this_thread::sleep_for(std::chrono::milliseconds(200)); 
-
     ConnectionPool pool;
-    auto firstBackend = makeBackend("127.0.0.1", 9200);
+    auto firstBackend = makeBackend("127.0.0.1", createDummyServer());
     int fd1 = pool.addNewConnection(firstBackend);
     ASSERT_GE(fd1, 0);
 
-    std::vector<std::pair<BackendConfig, int>> fds;
+    std::vector<std::pair<Backend, int>> fds;
     for (int i = 1; i < 12; ++i) {
-        auto tempBackend = makeBackend("127.0.0.1", 9200 + i);
+        auto tempBackend = makeBackend("127.0.0.1", createDummyServer());
         int fd = pool.addNewConnection(tempBackend);
         ASSERT_GE(fd, 0);
         fds.emplace_back(tempBackend, fd);
@@ -125,42 +130,34 @@ TEST(ConnectionPoolTest, PoolDeletesOldestWhenFull) {
         close(fd);
     }
     close(fd1);
-
-    int status = 0;
-    waitpid(pid, &status, 0);
-    EXPECT_TRUE(WIFEXITED(status));
 }
 
 
 TEST(ConnectionPoolTest, ThreadSafety) {
     const int THREAD_COUNT = 5;
-    const int BASE_PORT = 9300;
-
-    for (int i = 0; i < THREAD_COUNT; ++i) {
-        createDummyServer(BASE_PORT + i);
-    }
+    const int ROUNDS = 200;
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::vector<Backend> backends;
+    for (int i = 0; i < THREAD_COUNT; ++i)
+        backends.push_back(makeBackend("127.0.0.1", createDummyServer()));
 
-    ConnectionPool pool;
+    ConnectionPool pool(ConnectionPoolConfig{}, ConnectionPool::DEFAULT_MAX_BACKENDS, THREAD_COUNT);
+    std::vector<int> fds(THREAD_COUNT, -1);
+    std::atomic<int> mismatches{0};
     std::vector<std::thread> threads;
 
+    // Each thread dials one connection, then borrows and returns it over and over while
+    // the others do the same on their shards.
     for (int i = 0; i < THREAD_COUNT; ++i) {
         threads.emplace_back([&, i]() {
-            auto backend = makeBackend("127.0.0.1", BASE_PORT + i);
-
-            int fd = ::socket(AF_INET, SOCK_STREAM, 0);
-            sockaddr_in backendAddr{};
-            backendAddr.sin_family = AF_INET;
-            backendAddr.sin_port = htons(BASE_PORT + i);
-            backendAddr.sin_addr.s_addr = inet_addr("127.0.0.1");
-
-            if (::connect(fd, (sockaddr*)&backendAddr, sizeof(backendAddr)) == 0) {
-                pool.release(backend, fd);
-                int got = pool.acquire(backend);
-                if (got >= 0) ::close(got);
-            } else {
-                close(fd);
+            ConnectionPool::bindThreadToShard(static_cast<size_t>(i));
+            fds[i] = pool.addNewConnection(backends[i]);
+            for (int round = 0; round < ROUNDS && fds[i] >= 0; ++round) {
+                int fd = pool.acquire(backends[i]);
+                if (fd != fds[i])
+                    ++mismatches;
+                if (fd >= 0)
+                    pool.release(backends[i], fd);
             }
         });
     }
@@ -168,30 +165,36 @@ TEST(ConnectionPoolTest, ThreadSafety) {
     for (auto& t : threads)
         t.join();
 
-    SUCCEED(); 
+    EXPECT_EQ(mismatches.load(), 0);
+    for (int i = 0; i < THREAD_COUNT; ++i) {
+        ASSERT_GE(fds[i], 0);
+        EXPECT_TRUE(pool.isConnectionInPool(backends[i], fds[i]));
+        EXPECT_EQ(pool.idleCount(backends[i]), 1u);
+    }
 }
 
 TEST(ConnectionPoolTest, AddNewConnectionCreatesSocket) {
     ConnectionPool pool;
-    auto backend = BackendConfig{"127.0.0.1", 9100};
 
     int serverFd = socket(AF_INET, SOCK_STREAM, 0);
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
-    addr.sin_port = htons(9100);
+    addr.sin_port = 0;
     addr.sin_addr.s_addr = INADDR_ANY;
     bind(serverFd, (sockaddr*)&addr, sizeof(addr));
     listen(serverFd, 1);
+    auto backend = makeBackend("127.0.0.1", boundPort(serverFd));
 
     int fd = pool.addNewConnection(backend);
     EXPECT_GE(fd, 0);
 
     close(fd);
+    close(serverFd);
 }
 
 TEST(ConnectionPoolTest, AcquireHandlesConnectionFailureGracefully) {
     ConnectionPool pool;
-    BackendConfig backend{"192.0.2.1", 9999}; 
+    auto backend = makeBackend("192.0.2.1", 9999);
 
     int fd = pool.addNewConnection(backend);
     EXPECT_EQ(fd, -1); 
@@ -199,12 +202,8 @@ TEST(ConnectionPoolTest, AcquireHandlesConnectionFailureGracefully) {
 
 TEST(ConnectionPoolTest, SeparateBackendsDoNotShareConnections) {
     ConnectionPool pool;
-    auto backendA = makeBackend("127.0.0.1", 9200);
-    auto backendB = makeBackend("127.0.0.1", 9201);
-
-    createDummyServer(9200);
-    createDummyServer(9201);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    auto backendA = makeBackend("127.0.0.1", createDummyServer());
+    auto backendB = makeBackend("127.0.0.1", createDummyServer());
 
     int fdA = pool.addNewConnection(backendA);
     int fdB = pool.addNewConnection(backendB);
@@ -239,8 +238,7 @@ TEST(ConnectionPoolTest, SeparateBackendsDoNotShareConnections) {
 
 TEST(ConnectionPoolTest, HandlesHighConcurrency) {
     ConnectionPool pool;
-    auto backend = makeBackend("127.0.0.1", 9400);
-    createDummyServer(9400);
+    auto backend = makeBackend("127.0.0.1", createDummyServer());
 
     const int THREADS = 50;
     std::vector<std::thread> workers;
@@ -265,12 +263,199 @@ TEST(ConnectionPoolTest, ReleaseInvalidFdDoesNotCrash) {
     SUCCEED();
 }
 
-TEST(ConnectionPoolTest, AcquireCreatesConnectionIfPoolEmpty) {
+TEST(ConnectionPoolTest, AcquireNeverDialsWhenPoolEmpty) {
     ConnectionPool pool;
-    createDummyServer(9500);
+    uint16_t port = createDummyServer();
 
-    BackendConfig backend{"127.0.0.1", 9500};
-    int fd = pool.acquire(backend); 
-    EXPECT_GE(fd, 0);
+    // Dialing would block the caller; an empty pool just says so.
+    auto backend = makeBackend("127.0.0.1", port);
+    EXPECT_EQ(pool.acquire(backend), -1);
+    EXPECT_FALSE(pool.isConnectionInPool(backend, 0));
+}
+
+TEST(ConnectionPoolTest, OtherThreadStealsReleasedConnection) {
+    uint16_t port = createDummyServer();
+
+    ConnectionPool pool(ConnectionPoolConfig{}, ConnectionPool::DEFAULT_MAX_BACKENDS, 4);
+    auto backend = makeBackend("127.0.0.1", port);
+    int fd = pool.addNewConnection(backend);
+    ASSERT_GE(fd, 0);
+
+    // The idle connection sits in this thread's shard; a thread with its own shard
+    // must still find it instead of dialing again.
+    int stolen = -1;
+    std::thread([&]() { stolen = pool.acquire(backend); }).join();
+    EXPECT_EQ(stolen, fd);
+    EXPECT_TRUE(pool.isConnectionInPool(backend, fd));
+    close(fd);
+}
+
+TEST(ConnectionPoolTest, ReleaseIgnoresFdsItDidNotLend) {
+    ConnectionPool pool;
+    auto backend = makeBackend("127.0.0.1", 9601);
+    int foreign = ::socket(AF_INET, SOCK_STREAM, 0);
+    pool.release(backend, foreign);
+    EXPECT_FALSE(pool.isConnectionInPool(backend, foreign));
+
+    EXPECT_EQ(pool.acquire(backend), -1);
+    close(foreign);
+}
+
+TEST(ConnectionPoolTest, DiscardFreesTheBackendSlot) {
+    uint16_t port = createDummyServer();
+
+    ConnectionPoolConfig config;
+    config.maxConnectionsPerBackend = 1;
+    ConnectionPool pool(config);
+    auto backend = makeBackend("127.0.0.1", port);
+    int fd = pool.addNewConnection(backend);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(pool.acquire(backend), fd);
+
+    // The borrower closed it: the pool must stop counting it against the cap.
+    pool.discard(backend, fd);
     close(fd);
+    EXPECT_FALSE(pool.isConnectionInPool(backend, fd));
+    EXPECT_EQ(pool.idleCount(backend), 0u);
+}
+
+TEST(ConnectionPoolTest, BackendCloseEvictsIdleConnection) {
+    uint16_t port = createDummyServer();   // accepts, then closes after 100ms
+
+    ConnectionPool pool;
+    auto backend = makeBackend("127.0.0.1", port);
+    int fd = pool.addNewConnection(backend);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(pool.reapClosed(), 0u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    pollfd pfd{pool.watchFd(), POLLIN, 0};
+    EXPECT_EQ(poll(&pfd, 1, 0), 1);
+    EXPECT_EQ(pool.reapClosed(), 1u);
+    EXPECT_EQ(pool.idleCount(backend), 0u);
+    EXPECT_EQ(pool.acquire(backend), -1);
+}
+
+TEST(ConnectionPoolTest, ExpiresIdleConnectionsPastTtl) {
+    uint16_t port = createDummyServer();
+
+    ConnectionPoolConfig config;
+    config.idleTtlMs = 20;
+    ConnectionPool pool(config);
+    auto backend = makeBackend("127.0.0.1", port);
+    ASSERT_GE(pool.addNewConnection(backend), 0);
+    EXPECT_EQ(pool.cleanupIdleConnections(), 0u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(pool.cleanupIdleConnections(), 1u);
+    EXPECT_EQ(pool.idleCount(backend), 0u);
+}
+
+TEST(ConnectionPoolTest, CapsActiveClientsAndQueuesThemInOrder) {
+    ConnectionPoolConfig config;
+    config.maxActivePerBackend = 1;
+    config.waitQueueDepth = 2;
+    ConnectionPool pool(config);
+    auto backend = makeBackend("127.0.0.1", 9605);
+
+    int fd = -2;
+    ASSERT_EQ(pool.admit(backend, fd), ConnectionPool::Admission::Granted);
+    EXPECT_EQ(fd, -1);   // nothing idle: the client dials
+    int dialed = socket(AF_INET, SOCK_STREAM, 0);
+    pool.adopt(backend, dialed);
+    EXPECT_EQ(pool.admit(backend, fd), ConnectionPool::Admission::Full);
+
+    std::vector<int> granted;
+    ConnectionPool::WaitTicket first = 0, second = 0, third = 0;
+    EXPECT_EQ(pool.wait(backend, [&](int f) { granted.push_back(1); EXPECT_EQ(f, -1); }, fd, first),
+              ConnectionPool::Admission::Queued);
+    EXPECT_EQ(pool.wait(backend, [&](int) { granted.push_back(2); }, fd, second),
+              ConnectionPool::Admission::Queued);
+    EXPECT_EQ(pool.wait(backend, [&](int) { granted.push_back(3); }, fd, third),
+              ConnectionPool::Admission::Rejected);
+
+    // The first client's backend closes: its slot moves to the head of the queue.
+    pool.discard(backend, dialed);
+    close(dialed);
+    EXPECT_EQ(granted, std::vector<int>{1});
+    pool.releaseSlot(backend);
+    EXPECT_EQ(granted, (std::vector<int>{1, 2}));
+
+    // Last slot freed with nobody waiting: the next arrival is admitted directly.
+    pool.releaseSlot(backend);
+    EXPECT_EQ(pool.admit(backend, fd), ConnectionPool::Admission::Granted);
+}
+
+TEST(ConnectionPoolTest, ReleaseHandsConnectionToWaiter) {
+    uint16_t port = createDummyServer();
+
+    ConnectionPoolConfig config;
+    config.maxActivePerBackend = 1;
+    config.waitQueueDepth = 1;
+    ConnectionPool pool(config);
+    auto backend = makeBackend("127.0.0.1", port);
+    ASSERT_GE(pool.addNewConnection(backend), 0);
+
+    int fd = -1;
+    ASSERT_EQ(pool.admit(backend, fd), ConnectionPool::Admission::Granted);
+    ASSERT_GE(fd, 0);
+
+    int handed = -1;
+    int ignored = -1;
+    ConnectionPool::WaitTicket ticket = 0;
+    ASSERT_EQ(pool.wait(backend, [&](int f) { handed = f; }, ignored, ticket), ConnectionPool::Admission::Queued);
+    pool.release(backend, fd);
+    EXPECT_EQ(handed, fd);
+    EXPECT_EQ(pool.idleCount(backend), 0u);
+    EXPECT_TRUE(pool.isConnectionInPool(backend, fd));
+}
+
+TEST(ConnectionPoolTest, CancelledWaiterIsSkipped) {
+    ConnectionPoolConfig config;
+    config.maxActivePerBackend = 1;
+    config.waitQueueDepth = 4;
+    ConnectionPool pool(config);
+    auto backend = makeBackend("127.0.0.1", 9607);
+
+    int fd = -1;
+    ASSERT_EQ(pool.admit(backend, fd), ConnectionPool::Admission::Granted);
+    bool granted = false;
+    ConnectionPool::WaitTicket ticket = 0;
+    ASSERT_EQ(pool.wait(backend, [&](int) { granted = true; }, fd, ticket), ConnectionPool::Admission::Queued);
+    EXPECT_TRUE(pool.cancelWait(backend, ticket));
+    EXPECT_FALSE(pool.cancelWait(backend, ticket));
+
+    pool.releaseSlot(backend);
+    EXPECT_FALSE(granted);
+    EXPECT_EQ(pool.admit(backend, fd), ConnectionPool::Admission::Granted);
+}
+
+TEST(ConnectionPoolTest, TracksFdsUpToTheOpenFileLimit) {
+    rlimit limit{};
+    ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &limit), 0);
+    ASSERT_GT(limit.rlim_cur, 0u);
+
+    ConnectionPoolConfig config;
+    config.maxActivePerBackend = 1;
+    config.waitQueueDepth = 1;
+    ConnectionPool pool(config);
+    auto backend = makeBackend("127.0.0.1", 9608);
+
+    int fd = -1;
+    ASSERT_EQ(pool.admit(backend, fd), ConnectionPool::Admission::Granted);
+    // The highest fd this process can hold, far past the first owner segments.
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(sock, 0);
+    int high = static_cast<int>(std::min<rlim_t>(limit.rlim_cur, INT32_MAX) - 1);
+    ASSERT_EQ(dup2(sock, high), high);
+    close(sock);
+    pool.adopt(backend, high);
+    EXPECT_TRUE(pool.isConnectionInPool(backend, high));
+
+    bool granted = false;
+    ConnectionPool::WaitTicket ticket = 0;
+    ASSERT_EQ(pool.wait(backend, [&](int) { granted = true; }, fd, ticket), ConnectionPool::Admission::Queued);
+    pool.discard(backend, high);
+    close(high);
+    EXPECT_TRUE(granted);
 }
@@ -1,11 +1,15 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include "connection.h"
+#include "connection_pool.h"
+#include "backend_pool.h"
 #include "logger.h"
+#include "mock_dependencies.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <unistd.h>
 #include <arpa/inet.h>
+#include <poll.h>
 #include <sys/fcntl.h>     
 #include <thread>
 #include <chrono>
@@ -15,7 +19,7 @@ using ::testing::HasSubstr;
 
 
 TEST(ConnectionTest, FailsToConnectInvalidAddress) {
-    BackendConfig backend{"256.256.256.256", 9999};  
+    Backend backend = Backend::resolve({"256.256.256.256", 9999}, 0);  
     Logger logger;
 
 
@@ -26,13 +30,26 @@ TEST(ConnectionTest, FailsToConnectInvalidAddress) {
 }
 
 TEST(ConnectionTest, FailsToConnectInvalidPort) {
-    BackendConfig backend{"127.0.0.1", 9999}; 
+    Backend backend = Backend::resolve({"127.0.0.1", 9999}, 0); 
     Logger logger;
 
     Connection conn(-1, -1, backend, logger);
-    bool result = conn.connectToBackend();
-
-    EXPECT_FALSE(result);
+    if (!conn.connectToBackend()) {
+        // Refused before connect() returned: nothing is left half-open.
+        EXPECT_LT(conn.getBackendFd(), 0);
+        EXPECT_FALSE(conn.isConnected());
+    } else {
+        // Non-blocking connect: the refusal arrives through SO_ERROR once the socket is
+        // writable, which is where the reactor picks it up.
+        EXPECT_FALSE(conn.isConnected());
+        ASSERT_GE(conn.getBackendFd(), 0);
+        pollfd pfd{conn.getBackendFd(), POLLOUT, 0};
+        ASSERT_EQ(poll(&pfd, 1, 1000), 1);
+        int err = 0;
+        socklen_t len = sizeof(err);
+        ASSERT_EQ(getsockopt(conn.getBackendFd(), SOL_SOCKET, SO_ERROR, &err, &len), 0);
+        EXPECT_EQ(err, ECONNREFUSED);
+    }
 }
 
   TEST(ConnectionTest, ConnectToValidLocalServer_Forked) {
@@ -70,7 +87,7 @@ TEST(ConnectionTest, FailsToConnectInvalidPort) {
     else {
         std::this_thread::sleep_for(std::chrono::milliseconds(50)); 
 
-        BackendConfig backend{"127.0.0.1", 12345};
+        Backend backend = Backend::resolve({"127.0.0.1", 12345}, 0);
         Logger logger;
 
         Connection conn(-1, -1, backend, logger);
@@ -87,3 +104,364 @@ TEST(ConnectionTest, FailsToConnectInvalidPort) {
         EXPECT_TRUE(WIFEXITED(status));
     }
 }
+
+// A connection proxying between two socketpairs: `client[0]` and `backendPair[1]` are
+// the peers a test drives, the connection owns `client[1]` and `backendPair[0]`.
+// Pools a test asks for are declared before the connection, so they outlive it.
+class ProxiedConnectionTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, client), 0);
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, backendPair), 0);
+    }
+
+    void TearDown() override {
+        conn.reset();
+        closePeer(client[0]);
+        closePeer(backendPair[1]);
+    }
+
+    Connection& makeConnection(const ConnectionOptions& options = ConnectionOptions()) {
+        conn = std::make_unique<Connection>(client[1], backendPair[0], backends.at(0), logger, options);
+        return *conn;
+    }
+
+    BufferPool& makeBufferPool(size_t chunkSize, size_t budget) {
+        bufferPool = std::make_unique<BufferPool>(chunkSize, budget);
+        return *bufferPool;
+    }
+
+    ConnectionPool& makeConnectionPool(const ConnectionPoolConfig& config = ConnectionPoolConfig()) {
+        connectionPool = std::make_unique<ConnectionPool>(config);
+        return *connectionPool;
+    }
+
+    static void closePeer(int& fd) {
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+    }
+
+    int client[2]{-1, -1};
+    int backendPair[2]{-1, -1};
+    BackendPool backends{{{"127.0.0.1", 9999}}};
+    const Backend& backend = backends.at(0);
+    std::unique_ptr<BufferPool> bufferPool;
+    std::unique_ptr<ConnectionPool> connectionPool;
+    Logger logger;
+    std::unique_ptr<Connection> conn;
+};
+
+#ifdef __linux__
+TEST_F(ProxiedConnectionTest, SpliceModeForwardsBothDirections) {
+    ConnectionOptions options;
+    options.useSplice = true;
+    Connection& conn = makeConnection(options);
+    conn.setConnected(true);
+
+    ASSERT_EQ(send(client[0], "request", 7, 0), 7);
+    conn.onReadable(client[1]);
+    char buf[16] = {};
+    ASSERT_EQ(recv(backendPair[1], buf, sizeof(buf), 0), 7);
+    EXPECT_EQ(std::string(buf, 7), "request");
+
+    ASSERT_EQ(send(backendPair[1], "response", 8, 0), 8);
+    conn.onReadable(backendPair[0]);
+    ASSERT_EQ(recv(client[0], buf, sizeof(buf), 0), 8);
+    EXPECT_EQ(std::string(buf, 8), "response");
+    EXPECT_TRUE(conn.isSpliceEnabled());
+}
+#endif
+
+TEST_F(ProxiedConnectionTest, BackpressurePausesClientUntilBackendDrains) {
+    ConnectionOptions options;
+    options.readBufferSize = 16;
+    Connection& conn = makeConnection(options);
+    ::testing::StrictMock<MockEventLoop> loop;
+    conn.attachEventLoop(&loop);
+
+    // The backend connect is still pending, so everything the client sends queues up.
+    std::string payload(32, 'x');
+    ASSERT_EQ(send(client[0], payload.data(), payload.size(), 0), 32);
+    EXPECT_CALL(loop, updateFd(client[1], false, false)).Times(1);
+    conn.onReadable(client[1]);
+    EXPECT_TRUE(conn.isReadPaused(client[1]));
+    EXPECT_EQ(conn.bufferedToBackend(), 16u);
+
+    // Spurious readiness while paused must not read past the bound.
+    conn.onReadable(client[1]);
+    EXPECT_EQ(conn.bufferedToBackend(), 16u);
+    ::testing::Mock::VerifyAndClearExpectations(&loop);
+
+    conn.setConnected(true);
+    EXPECT_CALL(loop, updateFd(backendPair[0], true, false)).Times(1);
+    EXPECT_CALL(loop, updateFd(client[1], true, false)).Times(1);
+    conn.onWritable(backendPair[0]);
+    EXPECT_FALSE(conn.isReadPaused(client[1]));
+    EXPECT_EQ(conn.bufferedToBackend(), 0u);
+
+    char buf[64];
+    EXPECT_EQ(recv(backendPair[1], buf, sizeof(buf), 0), 16);
+
+    // Closed while the loop is still alive.
+    EXPECT_CALL(loop, unregisterFd(_)).Times(2);
+    conn.closeAll();
+}
+
+static size_t drain(int fd) {
+    char buf[65536];
+    size_t total = 0;
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+        total += static_cast<size_t>(n);
+    return total;
+}
+
+TEST_F(ProxiedConnectionTest, ReadsUntilEagainInOneWakeup) {
+    ConnectionOptions options;
+    options.readBufferSize = 4096;
+    Connection& conn = makeConnection(options);
+    conn.setConnected(true);
+
+    std::string payload(32 * 1024, 'x');
+    ASSERT_EQ(send(client[0], payload.data(), payload.size(), 0), static_cast<ssize_t>(payload.size()));
+    conn.onReadable(client[1]);
+    EXPECT_EQ(drain(backendPair[1]), payload.size());
+}
+
+TEST_F(ProxiedConnectionTest, WakeupBudgetRearmsInsteadOfStarvingOthers) {
+    ConnectionOptions options;
+    options.readBufferSize = 4096;
+    options.wakeupBudget = 8192;
+    Connection& conn = makeConnection(options);
+    ::testing::NiceMock<MockEventLoop> loop;
+    conn.attachEventLoop(&loop);
+    conn.setConnected(true);
+
+    std::string payload(32 * 1024, 'x');
+    ASSERT_EQ(send(client[0], payload.data(), payload.size(), 0), static_cast<ssize_t>(payload.size()));
+    EXPECT_CALL(loop, updateFd(backendPair[0], true, false)).Times(1);
+    EXPECT_CALL(loop, updateFd(client[1], true, false)).Times(1);
+    conn.onReadable(client[1]);
+
+    size_t forwarded = drain(backendPair[1]);
+    EXPECT_GE(forwarded, options.wakeupBudget);
+    EXPECT_LT(forwarded, payload.size());
+
+    conn.closeAll();   // while the loop is still alive
+}
+
+TEST_F(ProxiedConnectionTest, ExhaustedBufferPoolPausesReadsInsteadOfAllocating) {
+    BufferPool& pool = makeBufferPool(4096, 4096);
+    char* hog = pool.acquire();
+    ASSERT_NE(hog, nullptr);
+
+    ConnectionOptions options;
+    options.readBufferSize = 4096;
+    options.writeBufferSize = 4096;
+    options.bufferPool = &pool;
+    Connection& conn = makeConnection(options);
+
+    // Backend connect still pending: nowhere to put the bytes, so reading stops.
+    ASSERT_EQ(send(client[0], "hello", 5, 0), 5);
+    conn.onReadable(client[1]);
+    EXPECT_TRUE(conn.isReadPaused(client[1]));
+    EXPECT_EQ(pool.inUse(), 1u);
+
+    pool.release(hog);
+    conn.onReadable(client[1]);
+    EXPECT_FALSE(conn.isReadPaused(client[1]));
+    EXPECT_EQ(conn.bufferedToBackend(), 5u);
+
+    conn.closeAll();
+    EXPECT_EQ(pool.inUse(), 0u);
+}
+
+TEST_F(ProxiedConnectionTest, ExhaustedBufferPoolForwardsWithoutBuffering) {
+    BufferPool& pool = makeBufferPool(4096, 4096);
+    char* hog = pool.acquire();
+    ASSERT_NE(hog, nullptr);
+
+    ConnectionOptions options;
+    options.readBufferSize = 4096;
+    options.writeBufferSize = 4096;
+    options.bufferPool = &pool;
+    Connection& conn = makeConnection(options);
+    conn.setConnected(true);
+
+    std::string payload(20000, 'x');
+    ASSERT_EQ(send(client[0], payload.data(), payload.size(), 0), static_cast<ssize_t>(payload.size()));
+    conn.onReadable(client[1]);
+    EXPECT_EQ(drain(backendPair[1]), payload.size());
+    EXPECT_EQ(pool.inUse(), 1u);
+    pool.release(hog);
+}
+
+TEST_F(ProxiedConnectionTest, IdleConnectionHoldsNoBuffers) {
+    BufferPool& pool = makeBufferPool(4096, 4 * 4096);
+    ConnectionOptions options;
+    options.bufferPool = &pool;
+    Connection& conn = makeConnection(options);
+    conn.setConnected(true);
+    EXPECT_EQ(pool.inUse(), 0u);
+    EXPECT_LT(conn.stateBytes(), 1024u);
+
+    // Traffic the target takes in full passes through without borrowing anything.
+    ASSERT_EQ(send(client[0], "ping", 4, 0), 4);
+    conn.onReadable(client[1]);
+    ASSERT_EQ(send(backendPair[1], "pong", 4, 0), 4);
+    conn.onReadable(backendPair[0]);
+    EXPECT_EQ(drain(backendPair[1]), 4u);
+    EXPECT_EQ(drain(client[0]), 4u);
+    EXPECT_EQ(pool.inUse(), 0u);
+    EXPECT_EQ(conn.stateBytes(), sizeof(Connection));
+}
+
+TEST_F(ProxiedConnectionTest, PartialSendBorrowsBufferUntilDrained) {
+    int small = 4096;
+    setsockopt(backendPair[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+
+    BufferPool& pool = makeBufferPool(4096, 4 * 4096);
+    ConnectionOptions options;
+    options.bufferPool = &pool;
+    Connection& conn = makeConnection(options);
+    conn.setConnected(true);
+
+    std::string payload(256 * 1024, 'x');
+    ssize_t queued = send(client[0], payload.data(), payload.size(), 0);
+    ASSERT_GT(queued, 0);
+    conn.onReadable(client[1]);
+    EXPECT_GT(conn.bufferedToBackend(), 0u);
+    EXPECT_EQ(pool.inUse(), 1u);
+    EXPECT_EQ(conn.stateBytes(), sizeof(Connection) + pool.chunkSize());
+
+    size_t forwarded = 0;
+    while (forwarded < static_cast<size_t>(queued)) {
+        forwarded += drain(backendPair[1]);
+        conn.onWritable(backendPair[0]);
+        conn.onReadable(client[1]);
+    }
+    EXPECT_EQ(forwarded, static_cast<size_t>(queued));
+    EXPECT_EQ(conn.bufferedToBackend(), 0u);
+    EXPECT_EQ(pool.inUse(), 0u);
+}
+
+TEST_F(ProxiedConnectionTest, ClientCloseReleasesBackendSlot) {
+    ConnectionPoolConfig config;
+    config.maxActivePerBackend = 1;
+    ConnectionPool& pool = makeConnectionPool(config);
+    int fd = -1;
+    ASSERT_EQ(pool.admit(backend, fd), ConnectionPool::Admission::Granted);
+    pool.adopt(backend, backendPair[0]);
+
+    ConnectionOptions options;
+    options.connectionPool = &pool;
+    Connection& conn = makeConnection(options);
+    conn.setConnected(true);
+    EXPECT_EQ(pool.admit(backend, fd), ConnectionPool::Admission::Full);
+
+    closePeer(client[0]);
+    conn.onReadable(client[1]);
+    EXPECT_FALSE(conn.hasBackendOpen());
+    EXPECT_EQ(pool.admit(backend, fd), ConnectionPool::Admission::Granted);
+}
+
+TEST_F(ProxiedConnectionTest, CleanClientCloseReturnsBackendToPool) {
+    ConnectionPool& pool = makeConnectionPool();
+    pool.adopt(backend, backendPair[0]);
+
+    ConnectionOptions options;
+    options.connectionPool = &pool;
+    options.reuseBackend = true;
+    Connection& conn = makeConnection(options);
+    conn.setConnected(true);
+
+    ASSERT_EQ(send(client[0], "GET", 3, 0), 3);
+    conn.onReadable(client[1]);
+    EXPECT_EQ(drain(backendPair[1]), 3u);
+    ASSERT_EQ(send(backendPair[1], "200", 3, 0), 3);
+    conn.onReadable(backendPair[0]);
+    EXPECT_EQ(drain(client[0]), 3u);
+
+    closePeer(client[0]);
+    conn.onReadable(client[1]);
+    EXPECT_FALSE(conn.hasBackendOpen());
+    EXPECT_EQ(pool.idleCount(backend), 1u);
+
+    // Still open on the backend's side, and the next client gets it.
+    char byte;
+    EXPECT_EQ(recv(backendPair[1], &byte, 1, MSG_DONTWAIT), -1);
+    EXPECT_EQ(errno, EAGAIN);
+    EXPECT_EQ(pool.acquire(backend), backendPair[0]);
+    pool.discard(backend, backendPair[0]);
+    close(backendPair[0]);
+}
+
+TEST_F(ProxiedConnectionTest, ClientCloseMidRequestClosesBackend) {
+    ConnectionPool& pool = makeConnectionPool();
+    pool.adopt(backend, backendPair[0]);
+
+    ConnectionOptions options;
+    options.connectionPool = &pool;
+    options.reuseBackend = true;
+    Connection& conn = makeConnection(options);
+    conn.setConnected(true);
+
+    // The backend has not answered yet: its next bytes belong to this client.
+    ASSERT_EQ(send(client[0], "GET", 3, 0), 3);
+    conn.onReadable(client[1]);
+    closePeer(client[0]);
+    conn.onReadable(client[1]);
+    EXPECT_FALSE(conn.hasBackendOpen());
+    EXPECT_EQ(pool.idleCount(backend), 0u);
+    EXPECT_EQ(drain(backendPair[1]), 3u);
+    char byte;
+    EXPECT_EQ(recv(backendPair[1], &byte, 1, MSG_DONTWAIT), 0);
+}
+
+TEST(ConnectionTest, CountsItselfAgainstItsBackend) {
+    BackendPool backends({{"127.0.0.1", 9999}});
+    const Backend& backend = backends.at(0);
+    Logger logger;
+    {
+        Connection first(-1, -1, backend, logger);
+        Connection second(-1, -1, backend, logger);
+        EXPECT_EQ(backends.activeConnections(0), 2u);
+    }
+    EXPECT_EQ(backends.activeConnections(0), 0u);
+}
+
+TEST_F(ProxiedConnectionTest, BackendResetCountsTowardEjection) {
+    OutlierDetectionConfig policy;
+    policy.consecutiveFailures = 1;
+    backends.enableOutlierDetection(policy);
+    Connection& conn = makeConnection();
+    conn.setConnected(true);
+
+    // Closing with unread bytes resets the stream.
+    ASSERT_EQ(send(backendPair[0], "GET", 3, 0), 3);
+    closePeer(backendPair[1]);
+    conn.onReadable(backendPair[0]);
+    EXPECT_FALSE(conn.hasBackendOpen());
+    EXPECT_TRUE(backends.isEjected(0));
+}
+
+TEST(ConnectionTest, PooledConnectionClosesHalfOpenCircuit) {
+    int backendPair[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, backendPair), 0);
+
+    OutlierDetectionConfig policy;
+    policy.consecutiveFailures = 1;
+    BackendPool backends({{"127.0.0.1", 9999}});
+    backends.enableOutlierDetection(policy);
+    backends.at(0).stats->recordFailure();
+    backends.at(0).stats->circuit = uint64_t(1);   // ejection over
+    ASSERT_TRUE(backends.admits(0));              // this client holds the trial
+
+    Logger logger;
+    Connection conn(-1, -1, backends.at(0), logger);
+    conn.adoptBackendFd(backendPair[0]);
+    ASSERT_TRUE(conn.connectToBackend());
+    EXPECT_FALSE(backends.isEjected(0));
+    close(backendPair[1]);
+}
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "health_monitor.h"
+#include "mock_dependencies.h"
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+static int listenOn(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, 64) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static uint16_t portOf(int fd) {
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    return ntohs(addr.sin_port);
+}
+
+// Answers every connection's first read with `reply`, then closes it.
+class ReplyingServer {
+public:
+    explicit ReplyingServer(std::string reply) : m_Reply(std::move(reply)), m_Fd(listenOn(0)) {
+        m_Thread = std::thread([this]() {
+            pollfd pfd{m_Fd, POLLIN, 0};
+            while (!m_Stop) {
+                if (poll(&pfd, 1, 10) <= 0)
+                    continue;
+                int client = accept(m_Fd, nullptr, nullptr);
+                if (client < 0)
+                    continue;
+                char buf[64];
+                if (recv(client, buf, sizeof(buf), 0) > 0)
+                    send(client, m_Reply.data(), m_Reply.size(), 0);
+                close(client);
+            }
+        });
+    }
+    ~ReplyingServer() {
+        m_Stop = true;
+        m_Thread.join();
+        close(m_Fd);
+    }
+    uint16_t port() const { return portOf(m_Fd); }
+
+private:
+    std::string m_Reply;
+    int m_Fd;
+    std::atomic<bool> m_Stop{false};
+    std::thread m_Thread;
+};
+
+class HealthMonitorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        m_Config.enabled = true;
+        m_Config.intervalMs = 20;
+        m_Config.timeoutMs = 200;
+        m_Config.healthyThreshold = 2;
+        m_Config.unhealthyThreshold = 2;
+    }
+
+    // Drives the monitor the way its reactor would, until `done` or the deadline.
+    bool pumpUntil(HealthMonitor& monitor, const std::function<bool()>& done,
+                   std::chrono::milliseconds limit = 3000ms) {
+        auto deadline = std::chrono::steady_clock::now() + limit;
+        pollfd pfd{monitor.eventFd(), POLLIN, 0};
+        while (std::chrono::steady_clock::now() < deadline) {
+            poll(&pfd, 1, 5);
+            monitor.processEvents();
+            monitor.tick();
+            if (done())
+                return true;
+        }
+        return false;
+    }
+
+    // A port nothing listens on: bound once to pick it, then released.
+    static uint16_t closedPort() {
+        int fd = listenOn(0);
+        uint16_t port = portOf(fd);
+        close(fd);
+        return port;
+    }
+
+    HealthCheckConfig m_Config;
+    ::testing::NiceMock<MockLogger> m_Logger;
+};
+
+TEST_F(HealthMonitorTest, TakesRefusingBackendOutAfterThreshold) {
+    int listener = listenOn(0);
+    BackendPool backends({{"127.0.0.1", portOf(listener)}, {"127.0.0.1", closedPort()}});
+    HealthMonitor monitor(backends, m_Config, m_Logger);
+    ASSERT_GE(monitor.eventFd(), 0);
+
+    EXPECT_TRUE(pumpUntil(monitor, [&]() { return !backends.isHealthy(1); }));
+    EXPECT_TRUE(backends.isHealthy(0));
+    EXPECT_EQ(backends.healthyCount(), 1u);
+    close(listener);
+}
+
+TEST_F(HealthMonitorTest, BringsBackendBackAfterHealthyThreshold) {
+    uint16_t port = closedPort();
+    BackendPool backends({{"127.0.0.1", port}});
+    HealthMonitor monitor(backends, m_Config, m_Logger);
+    ASSERT_TRUE(pumpUntil(monitor, [&]() { return !backends.isHealthy(0); }));
+
+    int listener = listenOn(port);
+    ASSERT_GE(listener, 0);
+    EXPECT_TRUE(pumpUntil(monitor, [&]() { return backends.isHealthy(0); }));
+    close(listener);
+}
+
+TEST_F(HealthMonitorTest, PayloadProbeNeedsTheExpectedReply) {
+    ReplyingServer good("+PONG\r\n");
+    ReplyingServer bad("-ERR unknown command\r\n");
+    m_Config.send = "PING\r\n";
+    m_Config.expect = "+PONG";
+    BackendPool backends({{"127.0.0.1", good.port()}, {"127.0.0.1", bad.port()}});
+    HealthMonitor monitor(backends, m_Config, m_Logger);
+
+    EXPECT_TRUE(pumpUntil(monitor, [&]() { return !backends.isHealthy(1); }));
+    EXPECT_TRUE(backends.isHealthy(0));
+}
+
+TEST_F(HealthMonitorTest, UnansweredProbeTimesOut) {
+    // Accepts into the backlog but never replies.
+    int listener = listenOn(0);
+    m_Config.send = "PING\r\n";
+    m_Config.expect = "+PONG";
+    m_Config.timeoutMs = 30;
+    BackendPool backends({{"127.0.0.1", portOf(listener)}});
+    HealthMonitor monitor(backends, m_Config, m_Logger);
+
+    EXPECT_TRUE(pumpUntil(monitor, [&]() { return !backends.isHealthy(0); }));
+    close(listener);
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include "maglev_table.h"
+#include <stdexcept>
+
+using namespace std;
+
+static vector<string> backendNames(size_t count) {
+    vector<string> names;
+    for (size_t i = 0; i < count; ++i)
+        names.push_back("10.0.0." + to_string(i + 1) + ":8080");
+    return names;
+}
+
+TEST(MaglevTableTest, SpreadsSlotsEvenlyAcrossBackends) {
+    MaglevTable table(backendNames(5));
+    ASSERT_EQ(table.size(), MaglevTable::DEFAULT_SIZE);
+
+    vector<size_t> owned(5, 0);
+    for (uint64_t key = 0; key < table.size(); ++key)
+        ++owned[table.lookup(key)];
+    for (size_t count : owned) {
+        // Maglev's turn-taking keeps every share within one slot of size / N.
+        EXPECT_GE(count, table.size() / 5 - 1);
+        EXPECT_LE(count, table.size() / 5 + 1);
+    }
+}
+
+TEST(MaglevTableTest, SameBackendsGiveTheSameTable) {
+    MaglevTable a(backendNames(4));
+    MaglevTable b(backendNames(4));
+    for (uint64_t key = 0; key < a.size(); ++key)
+        ASSERT_EQ(a.lookup(key), b.lookup(key));
+}
+
+TEST(MaglevTableTest, RemovingABackendMovesAboutItsShare) {
+    const size_t count = 10;
+    vector<string> names = backendNames(count);
+    MaglevTable before(names);
+
+    vector<string> fewer = names;
+    fewer.erase(fewer.begin() + 3);
+    MaglevTable after(fewer);
+
+    size_t moved = 0;
+    for (uint64_t key = 0; key < before.size(); ++key) {
+        const string& was = names[before.lookup(key)];
+        const string& now = fewer[after.lookup(key)];
+        if (was == names[3])
+            continue;   // had to move
+        if (was != now)
+            ++moved;
+    }
+    // Only the removed backend's tenth must move; Maglev disturbs a few percent more.
+    EXPECT_LT(moved, before.size() / 20);
+}
+
+TEST(MaglevTableTest, RejectsTablesNoLargerThanTheFleet) {
+    EXPECT_THROW(MaglevTable({}), invalid_argument);
+    EXPECT_THROW(MaglevTable(backendNames(7), 7), invalid_argument);
+}
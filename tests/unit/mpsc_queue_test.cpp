@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "mpsc_queue.h"
+#include <thread>
+#include <vector>
+#include <atomic>
+
+TEST(MpscQueueTest, CapacityRoundsUpToPowerOfTwo) {
+    MpscQueue<int> queue(5);
+    EXPECT_EQ(queue.capacity(), 8u);
+}
+
+TEST(MpscQueueTest, PopsInFifoOrder) {
+    MpscQueue<int> queue(4);
+    int value = 0;
+    EXPECT_FALSE(queue.tryPop(value));
+
+    for (int i = 1; i <= 3; ++i)
+        ASSERT_TRUE(queue.tryPush(int(i)));
+
+    for (int i = 1; i <= 3; ++i) {
+        ASSERT_TRUE(queue.tryPop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.tryPop(value));
+}
+
+TEST(MpscQueueTest, RejectsPushWhenFull) {
+    MpscQueue<int> queue(2);
+    EXPECT_TRUE(queue.tryPush(1));
+    EXPECT_TRUE(queue.tryPush(2));
+    EXPECT_FALSE(queue.tryPush(3));
+
+    int value = 0;
+    ASSERT_TRUE(queue.tryPop(value));
+    EXPECT_TRUE(queue.tryPush(3));
+}
+
+TEST(MpscQueueTest, ManyProducersOneConsumerLoseNothing) {
+    constexpr int PRODUCERS = 4;
+    constexpr int PER_PRODUCER = 20000;
+    MpscQueue<int> queue(1024);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p]() {
+            for (int i = 0; i < PER_PRODUCER; ++i) {
+                int value = p * PER_PRODUCER + i;
+                while (!queue.tryPush(std::move(value)))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    std::vector<int> lastSeen(PRODUCERS, -1);
+    long long sum = 0;
+    int received = 0;
+    while (received < PRODUCERS * PER_PRODUCER) {
+        int value;
+        if (!queue.tryPop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        int producer = value / PER_PRODUCER;
+        EXPECT_GT(value, lastSeen[producer]);   // per-producer order is preserved
+        lastSeen[producer] = value;
+        sum += value;
+        received++;
+    }
+
+    for (auto& t : producers)
+        t.join();
+
+    long long n = PRODUCERS * PER_PRODUCER;
+    EXPECT_EQ(sum, n * (n - 1) / 2);
+}
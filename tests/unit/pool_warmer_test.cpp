@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "pool_warmer.h"
+#include "mock_dependencies.h"
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// A listener that never accepts: the kernel still completes handshakes up to the backlog.
+class PoolWarmerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        m_Listener = socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_GE(m_Listener, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ASSERT_EQ(bind(m_Listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+        ASSERT_EQ(listen(m_Listener, 64), 0);
+        socklen_t len = sizeof(addr);
+        getsockname(m_Listener, reinterpret_cast<sockaddr*>(&addr), &len);
+        m_Backends = std::make_unique<BackendPool>(std::vector<BackendConfig>{{"127.0.0.1", ntohs(addr.sin_port)}});
+    }
+    void TearDown() override { close(m_Listener); }
+
+    const Backend& backend() { return m_Backends->at(0); }
+
+    int m_Listener{-1};
+    std::unique_ptr<BackendPool> m_Backends;
+    ::testing::NiceMock<MockLogger> m_Logger;
+};
+
+TEST_F(PoolWarmerTest, PrewarmsMinIdleOnFirstPass) {
+    ConnectionPoolConfig config;
+    config.minIdle = 2;
+    config.maxIdle = 4;
+    ConnectionPool pool(config, m_Backends->size(), 2);
+    PoolWarmer warmer(pool, *m_Backends, config, m_Logger);
+
+    warmer.runOnce(std::chrono::seconds(0));
+    EXPECT_EQ(pool.idleCount(backend()), 2u);
+}
+
+TEST_F(PoolWarmerTest, WarmSetFollowsAcquireRate) {
+    ConnectionPoolConfig config;
+    config.minIdle = 0;
+    config.maxIdle = 8;
+    config.maxConnectionsPerBackend = 64;
+    config.maintenanceIntervalMs = 1000;
+    ConnectionPool pool(config, m_Backends->size(), 2);
+    PoolWarmer warmer(pool, *m_Backends, config, m_Logger);
+
+    warmer.runOnce(std::chrono::seconds(0));
+    EXPECT_EQ(pool.idleCount(backend()), 0u);
+
+    // A burst of clients, all of which missed the (empty) pool.
+    for (int i = 0; i < 20; ++i)
+        EXPECT_EQ(pool.acquire(backend()), -1);
+    warmer.runOnce(std::chrono::seconds(1));
+    EXPECT_GT(warmer.acquireRate(0), 0.0);
+    size_t warmed = pool.idleCount(backend());
+    EXPECT_GT(warmed, 0u);
+    EXPECT_LE(warmed, config.maxIdle);
+
+    // Demand gone: the estimate decays back toward minIdle.
+    for (int i = 0; i < 20; ++i)
+        warmer.runOnce(std::chrono::seconds(1));
+    EXPECT_EQ(warmer.targetIdle(0), config.minIdle);
+}
+
+TEST_F(PoolWarmerTest, TrimsIdleAboveMax) {
+    ConnectionPoolConfig config;
+    config.maxIdle = 2;
+    ConnectionPool pool(config, m_Backends->size(), 2);
+    for (int i = 0; i < 5; ++i)
+        ASSERT_GE(pool.addNewConnection(backend()), 0);
+
+    PoolWarmer warmer(pool, *m_Backends, config, m_Logger);
+    warmer.runOnce(std::chrono::seconds(1));
+    EXPECT_EQ(pool.idleCount(backend()), 2u);
+}
+
+TEST_F(PoolWarmerTest, DeadBackendDoesNotHoldUpTheOthers) {
+    // A port nothing listens on, ahead of the live backend in the same pass.
+    int closed = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(closed, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    socklen_t len = sizeof(addr);
+    getsockname(closed, reinterpret_cast<sockaddr*>(&addr), &len);
+    close(closed);
+    BackendPool backends({{"127.0.0.1", ntohs(addr.sin_port)}, backend()});
+
+    ConnectionPoolConfig config;
+    config.minIdle = 3;
+    ConnectionPool pool(config, backends.size(), 2);
+    PoolWarmer warmer(pool, backends, config, m_Logger);
+    warmer.runOnce(std::chrono::seconds(0));
+    EXPECT_EQ(pool.idleCount(backends.at(0)), 0u);
+    EXPECT_EQ(pool.idleCount(backends.at(1)), 3u);
+}
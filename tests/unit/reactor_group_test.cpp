@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "reactor_group.h"
+#include "connection_pool.h"
+#include "../mocks/mock_dependencies.h"
+#include <thread>
+
+using ::testing::NiceMock;
+
+TEST(ReactorGroupTest, ExplicitThreadCountIsHonored) {
+    EXPECT_EQ(ReactorGroup::resolveThreadCount(4), 4u);
+    EXPECT_EQ(ReactorGroup::resolveThreadCount(1), 1u);
+}
+
+TEST(ReactorGroupTest, ZeroThreadsUsesAvailableCpus) {
+    size_t cpus = ReactorGroup::availableCpus();
+    EXPECT_GE(cpus, 1u);
+    EXPECT_LE(cpus, std::max<size_t>(std::thread::hardware_concurrency(), 1));
+    EXPECT_EQ(ReactorGroup::resolveThreadCount(0), cpus);
+}
+
+TEST(ReactorGroupTest, ZeroReactorsThrows) {
+    NiceMock<MockLogger> logger;
+    ConnectionPool connectionPool;
+    EXPECT_THROW(ReactorGroup(0, logger, connectionPool), std::runtime_error);
+}
+
+TEST(ReactorGroupTest, EachReactorGetsItsOwnLoop) {
+    NiceMock<MockLogger> logger;
+    ConnectionPool connectionPool;
+    std::vector<IEventLoop*> loops;
+
+    ReactorGroup group(3, logger, connectionPool, [&]() {
+        auto loop = std::make_unique<NiceMock<MockEventLoop>>();
+        loops.push_back(loop.get());
+        return loop;
+    });
+
+    ASSERT_EQ(group.size(), 3u);
+    ASSERT_EQ(loops.size(), 3u);
+    for (size_t i = 0; i < group.size(); ++i)
+        EXPECT_EQ(group.at(i).getEventLoopForTest(), loops[i]);
+}
+
+TEST(ReactorGroupTest, NextDistributesRoundRobin) {
+    NiceMock<MockLogger> logger;
+    ConnectionPool connectionPool;
+    ReactorGroup group(3, logger, connectionPool, []() {
+        return std::make_unique<NiceMock<MockEventLoop>>();
+    });
+
+    Reactor* first = &group.next();
+    Reactor* second = &group.next();
+    Reactor* third = &group.next();
+
+    EXPECT_NE(first, second);
+    EXPECT_NE(second, third);
+    EXPECT_NE(first, third);
+    EXPECT_EQ(&group.next(), first);
+}
+
+TEST(ReactorGroupTest, StartAndStopJoinsAllThreads) {
+    NiceMock<MockLogger> logger;
+    ConnectionPool connectionPool;
+    ReactorGroup group(2, logger, connectionPool);
+
+    group.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    group.stop();
+    group.stop();
+
+    SUCCEED();
+}
@@ -4,6 +4,8 @@
 #include "connection_pool.h"
 #include "../mocks/mock_dependencies.h"
 #include <thread>
+#include <sys/socket.h>
+#include <unistd.h>
 
 using ::testing::_;
 using ::testing::Return;
@@ -93,3 +95,361 @@ TEST(ReactorTest, StopClosesLoop) {
     EXPECT_CALL(*loopPtr, closeLoop()).Times(1);
 
 }
+
+TEST(ReactorTest, DispatchesEventsToRegisteredHandler) {
+    auto mockLoop = std::make_unique<MockEventLoop>();
+    MockLogger logger;
+    ConnectionPool connectionPool;
+    auto* loopPtr = mockLoop.get();
+    Reactor reactor(std::move(mockLoop), logger, connectionPool);
+
+    int listenFd = 7;
+    EXPECT_CALL(*loopPtr, registerFd(listenFd, true, false)).WillOnce(Return(true));
+
+    int calls = 0;
+    ASSERT_TRUE(reactor.registerHandler(listenFd, [&](const Event& e) {
+        EXPECT_EQ(e.fd, listenFd);
+        calls++;
+    }));
+
+    Event e{listenFd, true, false, false, false};
+    reactor.handleEvent(e);
+    EXPECT_EQ(calls, 1);
+
+    EXPECT_CALL(*loopPtr, unregisterFd(listenFd)).Times(1);
+    reactor.unregisterHandler(listenFd);
+    reactor.handleEvent(e);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(ReactorTest, SlotTableGrowsForHighFdsAndClearsOnUnregister) {
+    auto mockLoop = std::make_unique<MockEventLoop>();
+    MockLogger logger;
+    ConnectionPool connectionPool;
+    auto* loopPtr = mockLoop.get();
+    Reactor reactor(std::move(mockLoop), logger, connectionPool);
+
+    auto conn = std::make_shared<MockConnection>();
+    int fd = 70000;
+    reactor.injectConnectionForTest(fd, conn);
+
+    Event e{fd, true, false, false, false};
+    EXPECT_CALL(*conn, onReadable(fd)).Times(1);
+    reactor.handleEvent(e);
+
+    EXPECT_CALL(*loopPtr, unregisterFd(fd)).Times(1);
+    reactor.unregisterConnection(fd);
+    reactor.handleEvent(e);
+}
+
+TEST(ReactorTest, IdleTimerClosesOnlyIdleConnections) {
+    auto mockLoop = std::make_unique<::testing::NiceMock<MockEventLoop>>();
+    ::testing::NiceMock<MockLogger> logger;
+    ConnectionPool connectionPool;
+    auto* loopPtr = mockLoop.get();
+    Reactor reactor(std::move(mockLoop), logger, connectionPool);
+    reactor.setIdleTimeout(std::chrono::seconds(5));
+
+    std::vector<IEventLoop::TimerCallback> timers;
+    std::vector<std::chrono::milliseconds> delays;
+    ON_CALL(*loopPtr, addTimer(_, _)).WillByDefault(Invoke(
+        [&](std::chrono::milliseconds delay, IEventLoop::TimerCallback cb) {
+            delays.push_back(delay);
+            timers.push_back(std::move(cb));
+            return static_cast<TimerId>(timers.size());
+        }));
+
+    auto conn = std::make_shared<::testing::NiceMock<MockConnection>>();
+    ON_CALL(*conn, getClientFd()).WillByDefault(Return(10));
+    ON_CALL(*conn, getBackendFd()).WillByDefault(Return(20));
+    ON_CALL(*conn, isConnected()).WillByDefault(Return(true));
+
+    auto now = std::chrono::steady_clock::now();
+    EXPECT_CALL(*conn, getLastActivity()).WillOnce(Return(now - std::chrono::seconds(2)));
+
+    reactor.registerConnection(conn, 10, 20);
+    ASSERT_EQ(timers.size(), 1u);
+    EXPECT_EQ(delays[0], std::chrono::seconds(5));
+
+    // Recent activity: re-armed for the remaining time rather than closed
+    EXPECT_CALL(*conn, closeAll()).Times(0);
+    auto first = timers[0];
+    first();
+    ASSERT_EQ(timers.size(), 2u);
+    EXPECT_LE(delays[1], std::chrono::seconds(3) + std::chrono::milliseconds(50));
+    ::testing::Mock::VerifyAndClearExpectations(conn.get());
+
+    EXPECT_CALL(*conn, getLastActivity()).WillOnce(Return(now - std::chrono::seconds(10)));
+    EXPECT_CALL(*conn, closeAll()).Times(1);
+    EXPECT_CALL(*loopPtr, unregisterFd(10)).Times(1);
+    EXPECT_CALL(*loopPtr, unregisterFd(20)).Times(1);
+    auto second = timers[1];
+    second();
+}
+
+TEST(ReactorTest, ConnectTimeoutClosesPendingBackend) {
+    auto mockLoop = std::make_unique<::testing::NiceMock<MockEventLoop>>();
+    ::testing::NiceMock<MockLogger> logger;
+    ConnectionPool connectionPool;
+    auto* loopPtr = mockLoop.get();
+    Reactor reactor(std::move(mockLoop), logger, connectionPool);
+    reactor.setConnectTimeout(std::chrono::milliseconds(100));
+
+    IEventLoop::TimerCallback deadline;
+    EXPECT_CALL(*loopPtr, addTimer(std::chrono::milliseconds(100), _)).WillOnce(Invoke(
+        [&](std::chrono::milliseconds, IEventLoop::TimerCallback cb) {
+            deadline = std::move(cb);
+            return TimerId{1};
+        }));
+
+    auto conn = std::make_shared<::testing::NiceMock<MockConnection>>();
+    ON_CALL(*conn, getClientFd()).WillByDefault(Return(11));
+    ON_CALL(*conn, getBackendFd()).WillByDefault(Return(21));
+    ON_CALL(*conn, isConnected()).WillByDefault(Return(false));
+
+    reactor.registerConnection(conn, 11, 21);
+    ASSERT_TRUE(deadline);
+
+    EXPECT_CALL(*conn, noteBackendFailure()).Times(1);
+    EXPECT_CALL(*conn, closeAll()).Times(1);
+    deadline();
+}
+
+TEST(ReactorTest, FailedBackendConnectClosesParkedClient) {
+    auto mockLoop = std::make_unique<::testing::NiceMock<MockEventLoop>>();
+    ::testing::NiceMock<MockLogger> logger;
+    ConnectionPool connectionPool;
+    auto* loopPtr = mockLoop.get();
+    Reactor reactor(std::move(mockLoop), logger, connectionPool);
+
+    auto conn = std::make_shared<::testing::NiceMock<MockConnection>>();
+    Backend backend = Backend::resolve({"127.0.0.1", 9000}, 0);
+    ON_CALL(*conn, getBackend()).WillByDefault(::testing::ReturnRef(backend));
+    ON_CALL(*conn, getClientFd()).WillByDefault(Return(12));
+    ON_CALL(*conn, getBackendFd()).WillByDefault(Return(22));
+    ON_CALL(*conn, isConnected()).WillByDefault(Return(false));
+    EXPECT_CALL(*conn, connectToBackend()).WillOnce(Return(true));
+    reactor.openConnection(conn);
+
+    EXPECT_CALL(*loopPtr, unregisterFd(12)).Times(1);
+    EXPECT_CALL(*loopPtr, unregisterFd(22)).Times(1);
+    EXPECT_CALL(*conn, noteBackendFailure()).Times(1);
+    EXPECT_CALL(*conn, closeAll()).Times(1);
+    Event refused{22, false, false, true, false};
+    reactor.handleEvent(refused);
+}
+
+TEST(ReactorTest, PostedTasksRunOnReactorThread) {
+    auto mockLoop = std::make_unique<::testing::NiceMock<MockEventLoop>>();
+    ::testing::NiceMock<MockLogger> logger;
+    ConnectionPool connectionPool;
+    ON_CALL(*mockLoop, wait(_, _)).WillByDefault(Invoke([](std::vector<Event>& events, int) {
+        events.clear();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return 0;
+    }));
+    Reactor reactor(std::move(mockLoop), logger, connectionPool);
+
+    std::thread reactorThread([&]() { reactor.run(); });
+    std::thread::id reactorId = reactorThread.get_id();
+
+    std::atomic<int> ran{0};
+    std::thread::id taskThread;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(reactor.post([&]() {
+            taskThread = std::this_thread::get_id();
+            ran++;
+        }));
+    }
+
+    for (int i = 0; i < 200 && ran.load() < 10; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    reactor.stop();
+    reactorThread.join();
+
+    EXPECT_EQ(ran.load(), 10);
+    EXPECT_EQ(taskThread, reactorId);
+    EXPECT_FALSE(reactor.isRunning());
+}
+
+TEST(ReactorTest, StopBeforeRunDoesNotHang) {
+    auto mockLoop = std::make_unique<::testing::NiceMock<MockEventLoop>>();
+    ::testing::NiceMock<MockLogger> logger;
+    ConnectionPool connectionPool;
+    Reactor reactor(std::move(mockLoop), logger, connectionPool);
+
+    reactor.stop();
+    std::thread reactorThread([&]() { reactor.run(); });
+    reactorThread.join();
+    SUCCEED();
+}
+
+TEST(ReactorTest, PostFailsWhenMailboxIsFull) {
+    auto mockLoop = std::make_unique<::testing::NiceMock<MockEventLoop>>();
+    ::testing::NiceMock<MockLogger> logger;
+    ConnectionPool connectionPool;
+    Reactor reactor(std::move(mockLoop), logger, connectionPool, 2);
+
+    EXPECT_TRUE(reactor.post([]() {}));
+    EXPECT_TRUE(reactor.post([]() {}));
+    EXPECT_FALSE(reactor.post([]() {}));
+}
+
+TEST(ReactorTest, RefusesConnectionsOverBackendCap) {
+    auto mockLoop = std::make_unique<::testing::NiceMock<MockEventLoop>>();
+    ::testing::NiceMock<MockLogger> logger;
+    ConnectionPoolConfig config;
+    config.maxActivePerBackend = 1;
+    ConnectionPool connectionPool(config);
+    Reactor reactor(std::move(mockLoop), logger, connectionPool);
+    Backend backend = Backend::resolve({"127.0.0.1", 9000}, 0);
+
+    auto first = std::make_shared<::testing::NiceMock<MockConnection>>();
+    ON_CALL(*first, getBackend()).WillByDefault(::testing::ReturnRef(backend));
+    ON_CALL(*first, getClientFd()).WillByDefault(Return(12));
+    ON_CALL(*first, getBackendFd()).WillByDefault(Return(-1));
+    EXPECT_CALL(*first, connectToBackend()).WillOnce(Return(true));
+    EXPECT_CALL(*first, closeAll()).Times(0);
+    reactor.openConnection(first);
+
+    auto second = std::make_shared<::testing::NiceMock<MockConnection>>();
+    ON_CALL(*second, getBackend()).WillByDefault(::testing::ReturnRef(backend));
+    ON_CALL(*second, getClientFd()).WillByDefault(Return(13));
+    EXPECT_CALL(*second, connectToBackend()).Times(0);
+    EXPECT_CALL(*second, closeAll()).Times(1);
+    reactor.openConnection(second);
+}
+
+TEST(ReactorTest, QueuedClientHangupFreesItsPlace) {
+    auto mockLoop = std::make_unique<::testing::NiceMock<MockEventLoop>>();
+    ::testing::NiceMock<MockLogger> logger;
+    ConnectionPoolConfig config;
+    config.maxActivePerBackend = 1;
+    config.waitQueueDepth = 1;
+    ConnectionPool connectionPool(config);
+    auto* loopPtr = mockLoop.get();
+    Reactor reactor(std::move(mockLoop), logger, connectionPool);
+    Backend backend = Backend::resolve({"127.0.0.1", 9000}, 0);
+
+    int client[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, client), 0);
+
+    auto first = std::make_shared<::testing::NiceMock<MockConnection>>();
+    ON_CALL(*first, getBackend()).WillByDefault(::testing::ReturnRef(backend));
+    ON_CALL(*first, getClientFd()).WillByDefault(Return(12));
+    ON_CALL(*first, getBackendFd()).WillByDefault(Return(-1));
+    EXPECT_CALL(*first, connectToBackend()).WillOnce(Return(true));
+    reactor.openConnection(first);
+
+    IEventLoop::TimerCallback deadline;
+    ON_CALL(*loopPtr, addTimer(_, _)).WillByDefault(Invoke(
+        [&](std::chrono::milliseconds, IEventLoop::TimerCallback cb) {
+            deadline = std::move(cb);
+            return TimerId{1};
+        }));
+    auto parked = std::make_shared<::testing::NiceMock<MockConnection>>();
+    ON_CALL(*parked, getBackend()).WillByDefault(::testing::ReturnRef(backend));
+    ON_CALL(*parked, getClientFd()).WillByDefault(Return(client[0]));
+    EXPECT_CALL(*loopPtr, registerFd(_, _, _)).WillRepeatedly(Return(true));
+    EXPECT_CALL(*loopPtr, registerFd(client[0], true, false)).WillOnce(Return(true));
+    EXPECT_CALL(*parked, connectToBackend()).Times(0);
+    reactor.openConnection(parked);
+    ASSERT_TRUE(deadline);
+
+    // Early request bytes are not a hangup.
+    ASSERT_EQ(write(client[1], "x", 1), 1);
+    Event data{client[0], true, false, false, false};
+    EXPECT_CALL(*parked, closeAll()).Times(0);
+    reactor.handleEvent(data);
+    ::testing::Mock::VerifyAndClearExpectations(parked.get());
+
+    char byte;
+    ASSERT_EQ(read(client[0], &byte, 1), 1);
+    close(client[1]);
+    EXPECT_CALL(*loopPtr, unregisterFd(client[0])).Times(1);
+    EXPECT_CALL(*parked, closeAll()).Times(1);
+    Event hangup{client[0], true, false, false, false};
+    reactor.handleEvent(hangup);
+
+    // The queue slot is free before the deadline: the next client queues, not refused.
+    auto next = std::make_shared<::testing::NiceMock<MockConnection>>();
+    ON_CALL(*next, getBackend()).WillByDefault(::testing::ReturnRef(backend));
+    ON_CALL(*next, getClientFd()).WillByDefault(Return(14));
+    EXPECT_CALL(*next, closeAll()).Times(0);
+    reactor.openConnection(next);
+
+    close(client[0]);
+}
+
+TEST(ReactorTest, StatsCountEachConnectionOnce) {
+    auto mockLoop = std::make_unique<::testing::NiceMock<MockEventLoop>>();
+    ::testing::NiceMock<MockLogger> logger;
+    ConnectionPool connectionPool;
+    Reactor reactor(std::move(mockLoop), logger, connectionPool);
+
+    auto proxied = std::make_shared<::testing::NiceMock<MockConnection>>();
+    ON_CALL(*proxied, getClientFd()).WillByDefault(Return(30));
+    ON_CALL(*proxied, getBackendFd()).WillByDefault(Return(15));
+    ON_CALL(*proxied, stateBytes()).WillByDefault(Return(300));
+    reactor.registerConnection(proxied, 30, 15);
+
+    auto halfOpen = std::make_shared<::testing::NiceMock<MockConnection>>();
+    ON_CALL(*halfOpen, getClientFd()).WillByDefault(Return(31));
+    ON_CALL(*halfOpen, getBackendFd()).WillByDefault(Return(-1));
+    ON_CALL(*halfOpen, stateBytes()).WillByDefault(Return(200));
+    reactor.registerConnection(halfOpen, 31, -1);
+
+    Reactor::Stats stats = reactor.stats();
+    EXPECT_EQ(stats.connections, 2u);
+    EXPECT_EQ(stats.stateBytes, 500u);
+
+    reactor.unregisterConnection(30);
+    reactor.unregisterConnection(15);
+    stats = reactor.stats();
+    EXPECT_EQ(stats.connections, 1u);
+    EXPECT_EQ(stats.stateBytes, 200u);
+}
+
+TEST(ReactorTest, RunsTimersOnlyAfterDispatchingTheBatch) {
+    auto mockLoop = std::make_unique<::testing::NiceMock<MockEventLoop>>();
+    ::testing::NiceMock<MockLogger> logger;
+    ConnectionPool connectionPool;
+    auto* loopPtr = mockLoop.get();
+    Reactor reactor(std::move(mockLoop), logger, connectionPool);
+
+    auto conn = std::make_shared<::testing::NiceMock<MockConnection>>();
+    ON_CALL(*conn, getClientFd()).WillByDefault(Return(40));
+    ON_CALL(*conn, getBackendFd()).WillByDefault(Return(41));
+    ON_CALL(*conn, isConnected()).WillByDefault(Return(true));
+    reactor.registerConnection(conn, 40, 41);
+
+    std::atomic<bool> dispatched{false};
+    std::atomic<bool> timersRan{false};
+    std::atomic<bool> timersBeforeDispatch{false};
+    ON_CALL(*loopPtr, wait(_, _)).WillByDefault(Invoke([&](std::vector<Event>& events, int) {
+        events.clear();
+        if (!timersRan)
+            events.push_back(Event{40, true, false, false, false});
+        else
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return static_cast<int>(events.size());
+    }));
+    ON_CALL(*conn, onReadable(40)).WillByDefault(Invoke([&](int) { dispatched = true; }));
+    ON_CALL(*loopPtr, runTimers()).WillByDefault(Invoke([&]() {
+        if (!dispatched)
+            timersBeforeDispatch = true;
+        timersRan = true;
+        return size_t{0};
+    }));
+
+    std::thread reactorThread([&]() { reactor.run(); });
+    for (int i = 0; i < 200 && !timersRan; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    reactor.stop();
+    reactorThread.join();
+
+    EXPECT_TRUE(dispatched);
+    EXPECT_TRUE(timersRan);
+    EXPECT_FALSE(timersBeforeDispatch);
+}
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+#include "ring_buffer.h"
+#include <string>
+
+TEST(RingBufferTest, WriteStopsAtCapacity) {
+    RingBuffer ring(8);
+    EXPECT_EQ(ring.write("0123456789", 10), 8u);
+    EXPECT_TRUE(ring.full());
+    EXPECT_EQ(ring.available(), 0u);
+
+    iovec spans[2];
+    EXPECT_EQ(ring.writableSpans(spans), 0);
+}
+
+TEST(RingBufferTest, WrapsWithoutMovingData) {
+    RingBuffer ring(8);
+    ring.write("abcdef", 6);
+
+    char out[8];
+    ASSERT_EQ(ring.read(out, 4), 4u);
+    EXPECT_EQ(std::string(out, 4), "abcd");
+
+    // Tail wraps: free space is [6,8) then [0,4).
+    ASSERT_EQ(ring.write("ghijkl", 6), 6u);
+    iovec spans[2];
+    ASSERT_EQ(ring.readableSpans(spans), 2);
+    EXPECT_EQ(std::string(static_cast<char*>(spans[0].iov_base), spans[0].iov_len), "efgh");
+    EXPECT_EQ(std::string(static_cast<char*>(spans[1].iov_base), spans[1].iov_len), "ijkl");
+
+    ring.consume(5);
+    ASSERT_EQ(ring.read(out, sizeof(out)), 3u);
+    EXPECT_EQ(std::string(out, 3), "jkl");
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(RingBufferTest, DrainingRewindsToSingleSpan) {
+    RingBuffer ring(8);
+    ring.write("abcde", 5);
+    ring.consume(5);
+
+    iovec spans[2];
+    ASSERT_EQ(ring.writableSpans(spans), 1);
+    EXPECT_EQ(spans[0].iov_len, 8u);
+
+    ring.commitWrite(3);
+    EXPECT_EQ(ring.size(), 3u);
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "router.h"
 #include "backend_pool.h"
+#include <arpa/inet.h>
+#include <set>
 
 using namespace std;
 
@@ -44,14 +46,174 @@ TEST_F(RouterTest, RouterSharesBackendPool) {
                 next.host == "127.0.0.2" || next.host == "127.0.0.3");
 }
 
-// ✅ Test 3: LeastConnections algorithm throws (not yet implemented)
-TEST_F(RouterTest, LeastConnectionsThrows) {
+// ✅ Test 3: LeastConnections picks the backend with the fewest active connections
+TEST_F(RouterTest, LeastConnectionsPicksFewestActive) {
     BackendPool pool(backends);
     Router router(pool, RoutingAlgorithm::LeastConnections);
 
-    EXPECT_THROW({
-        router.selectBackend();
-    }, std::runtime_error);
+    pool.at(0).stats->active = 5;
+    pool.at(1).stats->active = 1;
+    pool.at(2).stats->active = 3;
+    for (int i = 0; i < 6; ++i)
+        EXPECT_EQ(router.selectBackend().id, 1u);
+
+    pool.at(1).stats->active = 7;
+    EXPECT_EQ(router.selectBackend().id, 2u);
+}
+
+TEST_F(RouterTest, LeastConnectionsSpreadsTies) {
+    BackendPool pool(backends);
+    Router router(pool, RoutingAlgorithm::LeastConnections);
+
+    std::set<BackendId> picked;
+    for (int i = 0; i < 3; ++i)
+        picked.insert(router.selectBackend().id);
+    EXPECT_EQ(picked.size(), 3u);
+}
+
+TEST_F(RouterTest, PowerOfTwoChoicesPrefersTheCheaperBackend) {
+    BackendPool pool(backends);
+    Router router(pool, RoutingAlgorithm::PowerOfTwoChoices);
+    auto now = BackendStats::Clock::now();
+    pool.at(0).stats->observeLatency(std::chrono::milliseconds(2), now);
+    pool.at(1).stats->observeLatency(std::chrono::milliseconds(2), now);
+    pool.at(2).stats->observeLatency(std::chrono::milliseconds(200), now);
+
+    // The costliest backend loses every pairing it is drawn into.
+    std::set<BackendId> picked;
+    for (int i = 0; i < 200; ++i)
+        picked.insert(router.selectBackend().id);
+    EXPECT_EQ(picked, (std::set<BackendId>{0, 1}));
+
+}
+
+TEST_F(RouterTest, PowerOfTwoChoicesWeighsLatencyByLoad) {
+    BackendPool pool({{"127.0.0.1", 9001}, {"127.0.0.2", 9002}});
+    Router router(pool, RoutingAlgorithm::PowerOfTwoChoices);
+    auto now = BackendStats::Clock::now();
+    pool.at(0).stats->observeLatency(std::chrono::milliseconds(2), now);
+    pool.at(1).stats->observeLatency(std::chrono::milliseconds(5), now);
+    EXPECT_EQ(router.selectBackend().id, 0u);
+
+    // 2ms x 4 in flight costs more than 5ms x 1.
+    pool.at(0).stats->active = 3;
+    EXPECT_EQ(router.selectBackend().id, 1u);
+}
+
+TEST_F(RouterTest, ConsistentHashPinsEachClientToOneBackend) {
+    BackendPool pool(backends);
+    Router router(pool, RoutingAlgorithm::ConsistentHash);
+
+    set<BackendId> used;
+    for (uint32_t host = 1; host <= 64; ++host) {
+        sockaddr_in client{};
+        client.sin_addr.s_addr = htonl(0x0A000000 | host);
+        client.sin_port = htons(40000);
+        BackendId first = router.selectBackend(clientAffinityKey(client)).id;
+        used.insert(first);
+
+        // Another connection from the same IP, new source port: same backend.
+        client.sin_port = htons(40001);
+        EXPECT_EQ(router.selectBackend(clientAffinityKey(client)).id, first);
+    }
+    EXPECT_EQ(used.size(), 3u);
+}
+
+TEST_F(RouterTest, LeastConnectionsSkipsDownBackends) {
+    BackendPool pool(backends);
+    Router router(pool, RoutingAlgorithm::LeastConnections);
+    pool.at(0).stats->active = 4;
+    pool.at(2).stats->active = 2;
+    pool.setHealthy(1, false);
+
+    for (int i = 0; i < 6; ++i)
+        EXPECT_EQ(router.selectBackend().id, 2u);
+}
+
+TEST_F(RouterTest, PowerOfTwoChoicesSkipsDownBackends) {
+    BackendPool pool(backends);
+    Router router(pool, RoutingAlgorithm::PowerOfTwoChoices);
+    pool.setHealthy(0, false);
+    pool.setHealthy(2, false);
+
+    for (int i = 0; i < 50; ++i)
+        EXPECT_EQ(router.selectBackend().id, 1u);
+}
+
+TEST_F(RouterTest, ConsistentHashMovesOnlyTheDownBackendsClients) {
+    BackendPool pool(backends);
+    Router router(pool, RoutingAlgorithm::ConsistentHash);
+
+    vector<BackendId> before;
+    for (uint64_t key = 0; key < 3000; ++key)
+        before.push_back(router.selectBackend(key * 0x9E3779B97F4A7C15ull).id);
+
+    pool.setHealthy(1, false);
+    set<BackendId> rehomed;
+    for (uint64_t key = 0; key < 3000; ++key) {
+        BackendId now = router.selectBackend(key * 0x9E3779B97F4A7C15ull).id;
+        EXPECT_NE(now, 1u);
+        if (before[key] == 1)
+            rehomed.insert(now);
+        else
+            EXPECT_EQ(now, before[key]);
+    }
+    EXPECT_EQ(rehomed, (set<BackendId>{0, 2}));
+}
+
+TEST_F(RouterTest, LeastConnectionsSendsOneTrialToAnEjectedBackend) {
+    OutlierDetectionConfig policy;
+    policy.consecutiveFailures = 1;
+    BackendPool pool(backends);
+    pool.enableOutlierDetection(policy);
+    Router router(pool, RoutingAlgorithm::LeastConnections);
+    pool.at(0).stats->active = 1;
+    pool.at(1).stats->active = 1;
+    pool.at(2).stats->recordFailure();
+
+    for (int i = 0; i < 6; ++i)
+        EXPECT_NE(router.selectBackend().id, 2u);
+
+    pool.at(2).stats->circuit = uint64_t(1);   // ejection over
+    int trials = 0;
+    for (int i = 0; i < 6; ++i)
+        trials += router.selectBackend().id == 2u;
+    EXPECT_EQ(trials, 1);
+}
+
+TEST_F(RouterTest, ConsistentHashWithEveryBackendEjectedKeepsPrimaryAndFindsTrials) {
+    OutlierDetectionConfig policy;
+    policy.consecutiveFailures = 1;
+    policy.maxEjectionPercent = 100;
+    BackendPool pool(backends);
+    pool.enableOutlierDetection(policy);
+    Router router(pool, RoutingAlgorithm::ConsistentHash);
+
+    vector<BackendId> primary;
+    for (uint64_t key = 0; key < 30; ++key)
+        primary.push_back(router.selectBackend(key * 0x9E3779B97F4A7C15ull).id);
+    for (BackendId id = 0; id < pool.size(); ++id)
+        pool.at(id).stats->recordFailure();
+
+    // Nothing in rotation: the bounded walk gives up and fails open to the primary.
+    for (uint64_t key = 0; key < 30; ++key)
+        EXPECT_EQ(router.selectBackend(key * 0x9E3779B97F4A7C15ull).id, primary[key]);
+
+    // An ejection that ran out is still found as a half-open trial, once.
+    pool.at(2).stats->circuit = uint64_t(1);
+    int trials = 0;
+    for (uint64_t key = 0; key < 30; ++key)
+        trials += router.selectBackend(key * 0x9E3779B97F4A7C15ull).id == 2u && primary[key] != 2u;
+    EXPECT_LE(trials, 1);
+    EXPECT_EQ(pool.at(2).stats->circuitState(), BackendStats::Circuit::HalfOpen);
+}
+
+TEST_F(RouterTest, ParsesConfiguredAlgorithmNames) {
+    EXPECT_EQ(parseRoutingAlgorithm("roundRobin"), RoutingAlgorithm::RoundRobin);
+    EXPECT_EQ(parseRoutingAlgorithm("leastConnections"), RoutingAlgorithm::LeastConnections);
+    EXPECT_EQ(parseRoutingAlgorithm("powerOfTwoChoices"), RoutingAlgorithm::PowerOfTwoChoices);
+    EXPECT_EQ(parseRoutingAlgorithm("consistentHash"), RoutingAlgorithm::ConsistentHash);
+    EXPECT_THROW(parseRoutingAlgorithm("fastest"), std::invalid_argument);
 }
 
 // ✅ Test 4: Random algorithm throws (not yet implemented)
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include "slab_allocator.h"
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+struct Widget {
+    explicit Widget(int v) : value(v) {}
+    int value;
+    char payload[200];
+};
+
+struct Other {
+    char payload[136];
+};
+}
+
+TEST(SlabAllocatorTest, RecyclesFreedBlocks) {
+    auto first = std::allocate_shared<Widget>(SlabAllocator<Widget>(), 1);
+    Widget* address = first.get();
+    first.reset();
+
+    auto second = std::allocate_shared<Widget>(SlabAllocator<Widget>(), 2);
+    EXPECT_EQ(second.get(), address);
+    EXPECT_EQ(second->value, 2);
+}
+
+TEST(SlabAllocatorTest, SteadyStateDoesNotGrowSlabs) {
+    using Pool = BlockPool<sizeof(Other), alignof(Other)>;
+    SlabAllocator<Other> alloc;
+    std::vector<Other*> live;
+    for (int i = 0; i < 500; ++i)
+        live.push_back(alloc.allocate(1));
+    for (Other* p : live)
+        alloc.deallocate(p, 1);
+    size_t slabs = Pool::instance().slabCount();
+
+    for (int round = 0; round < 10; ++round) {
+        live.clear();
+        for (int i = 0; i < 500; ++i)
+            live.push_back(alloc.allocate(1));
+        std::set<Other*> unique(live.begin(), live.end());
+        EXPECT_EQ(unique.size(), live.size());
+        for (Other* p : live)
+            alloc.deallocate(p, 1);
+    }
+    EXPECT_EQ(Pool::instance().slabCount(), slabs);
+}
+
+TEST(SlabAllocatorTest, BlocksFreedOnAnotherThreadComeBack) {
+    using Pool = BlockPool<sizeof(Widget), alignof(Widget)>;
+    std::vector<std::shared_ptr<Widget>> made;
+    for (int i = 0; i < 1000; ++i)
+        made.push_back(std::allocate_shared<Widget>(SlabAllocator<Widget>(), i));
+    size_t slabs = Pool::instance().slabCount();
+
+    // Producer on this thread, consumer frees on another, as with acceptor -> reactor.
+    std::thread consumer([&]() { made.clear(); });
+    consumer.join();
+
+    for (int i = 0; i < 1000; ++i)
+        made.push_back(std::allocate_shared<Widget>(SlabAllocator<Widget>(), i));
+    EXPECT_EQ(Pool::instance().slabCount(), slabs);
+}
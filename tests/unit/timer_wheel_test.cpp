@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include "timer_wheel.h"
+#include <vector>
+
+using namespace std::chrono;
+using Clock = TimerWheel::Clock;
+
+class TimerWheelTest : public ::testing::Test {
+protected:
+    Clock::time_point start = Clock::now();
+    TimerWheel wheel{milliseconds(10), 8, start};
+};
+
+TEST_F(TimerWheelTest, FiresOnlyOnceDue) {
+    int fired = 0;
+    wheel.schedule(milliseconds(30), [&]() { fired++; }, start);
+
+    EXPECT_EQ(wheel.advance(start + milliseconds(20)), 0u);
+    EXPECT_EQ(fired, 0);
+    EXPECT_EQ(wheel.advance(start + milliseconds(30)), 1u);
+    EXPECT_EQ(fired, 1);
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST_F(TimerWheelTest, CancelPreventsFiring) {
+    int fired = 0;
+    TimerId id = wheel.schedule(milliseconds(10), [&]() { fired++; }, start);
+
+    EXPECT_TRUE(wheel.cancel(id));
+    EXPECT_FALSE(wheel.cancel(id));
+    wheel.advance(start + milliseconds(100));
+    EXPECT_EQ(fired, 0);
+}
+
+TEST_F(TimerWheelTest, TimersBeyondOneRevolutionWaitForTheirRound) {
+    // 8 slots * 10ms = 80ms per revolution
+    int fired = 0;
+    wheel.schedule(milliseconds(250), [&]() { fired++; }, start);
+
+    wheel.advance(start + milliseconds(90));
+    wheel.advance(start + milliseconds(170));
+    EXPECT_EQ(fired, 0);
+    wheel.advance(start + milliseconds(250));
+    EXPECT_EQ(fired, 1);
+}
+
+TEST_F(TimerWheelTest, FiresInDeadlineOrderAcrossTicks) {
+    std::vector<int> order;
+    wheel.schedule(milliseconds(40), [&]() { order.push_back(2); }, start);
+    wheel.schedule(milliseconds(10), [&]() { order.push_back(1); }, start);
+
+    wheel.advance(start + milliseconds(50));
+    EXPECT_EQ(order, (std::vector<int>{1, 2}));
+}
+
+TEST_F(TimerWheelTest, CallbackMayRescheduleAndCancel) {
+    int fired = 0;
+    TimerId other = wheel.schedule(milliseconds(10), [&]() { fired += 100; }, start);
+    wheel.schedule(milliseconds(10), [&]() {
+        fired++;
+        wheel.cancel(other);
+        wheel.schedule(milliseconds(10), [&]() { fired++; }, start + milliseconds(10));
+    }, start);
+
+    wheel.advance(start + milliseconds(10));
+    wheel.advance(start + milliseconds(20));
+    // Either order within the tick is fine, but "other" must not fire after being cancelled
+    EXPECT_TRUE(fired == 2 || fired == 102);
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST_F(TimerWheelTest, NextTimeoutTracksNearestOccupiedTick) {
+    EXPECT_EQ(wheel.nextTimeoutMs(1000, start), 1000);
+    EXPECT_EQ(wheel.nextTimeoutMs(-1, start), -1);
+
+    wheel.schedule(milliseconds(30), []() {}, start);
+    EXPECT_EQ(wheel.nextTimeoutMs(1000, start), 30);
+    EXPECT_EQ(wheel.nextTimeoutMs(5, start), 5);
+    EXPECT_EQ(wheel.nextTimeoutMs(1000, start + milliseconds(50)), 0);
+}
+
+TEST_F(TimerWheelTest, DelayCountsFromScheduleTimeNotLastAdvance) {
+    // The wheel was last advanced at `start`; the loop then spent 100ms dispatching.
+    int fired = 0;
+    wheel.schedule(milliseconds(30), [&]() { fired++; }, start + milliseconds(100));
+
+    wheel.advance(start + milliseconds(105));
+    EXPECT_EQ(fired, 0);
+    wheel.advance(start + milliseconds(125));
+    EXPECT_EQ(fired, 0);
+    wheel.advance(start + milliseconds(130));
+    EXPECT_EQ(fired, 1);
+}
+
+TEST_F(TimerWheelTest, RoundsPartialTicksUp) {
+    int fired = 0;
+    wheel.schedule(milliseconds(10), [&]() { fired++; }, start + milliseconds(5));
+
+    wheel.advance(start + milliseconds(10));
+    EXPECT_EQ(fired, 0);
+    wheel.advance(start + milliseconds(20));
+    EXPECT_EQ(fired, 1);
+}